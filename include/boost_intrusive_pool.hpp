@@ -23,6 +23,50 @@
 #include <boost/smart_ptr/intrusive_ptr.hpp>
 #include <boost/smart_ptr/intrusive_ref_counter.hpp>
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#if __cplusplus >= 201703L && defined(__has_include)
+#if __has_include(<memory_resource>)
+#include <memory_resource>
+#define BOOST_INTRUSIVE_POOL_HAVE_PMR 1
+#endif
+#endif
+
+#ifdef __linux__
+#include <sched.h> // for sched_getcpu()
+#include <sys/mman.h> // for mmap(), madvise() and mlock()
+#include <sys/syscall.h> // for the mbind() and get_mempolicy() system calls
+#include <unistd.h> // for syscall() and sysconf()
+#endif
+
+#ifndef BOOST_INTRUSIVE_POOL_HAVE_RSEQ
+// glibc >= 2.35 registers a restartable-sequences area for each thread, whose cpu_id field is kept up to date by the
+// kernel: reading the current CPU from there is much cheaper than invoking sched_getcpu()
+#if defined(__linux__) && defined(__GLIBC__) && defined(__has_builtin)
+#if (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 35)) && __has_builtin(__builtin_thread_pointer)
+#define BOOST_INTRUSIVE_POOL_HAVE_RSEQ (1)
+#endif
+#endif
+#ifndef BOOST_INTRUSIVE_POOL_HAVE_RSEQ
+#define BOOST_INTRUSIVE_POOL_HAVE_RSEQ (0)
+#endif
+#endif
+
+#if BOOST_INTRUSIVE_POOL_HAVE_RSEQ
+#include <sys/rseq.h>
+#endif
+
 //------------------------------------------------------------------------------
 // Constants
 //------------------------------------------------------------------------------
@@ -40,11 +84,8 @@
 
 #ifndef BOOST_INTRUSIVE_POOL_DEBUG_THREAD_ACCESS
 // if you define BOOST_INTRUSIVE_POOL_DEBUG_THREAD_ACCESS=1 before including this header file,
-// you will activate a pthread-specific check about correct thread access to the memory pool
+// you will activate a check about items of a boost_intrusive_pool being allocated only by the thread owning the pool
 #define BOOST_INTRUSIVE_POOL_DEBUG_THREAD_ACCESS (0)
-#else
-// checks are active: we use pthread_self() API:
-#include <pthread.h>
 #endif
 
 #ifndef BOOST_INTRUSIVE_POOL_DEBUG_MAX_REFCOUNT
@@ -53,6 +94,51 @@
 #define BOOST_INTRUSIVE_POOL_DEBUG_MAX_REFCOUNT (1024)
 #endif
 
+#ifndef BOOST_INTRUSIVE_POOL_MAX_THREAD_MAGAZINES
+// maximum number of concurrent_boost_intrusive_pool instances for which each thread can keep a magazine
+// of free items; pools used by a thread beyond this limit just bypass the per-thread cache
+#define BOOST_INTRUSIVE_POOL_MAX_THREAD_MAGAZINES (8)
+#endif
+
+#ifndef BOOST_INTRUSIVE_POOL_SHARD_STEAL_BATCH
+// maximum number of free items that an empty shard of a sharded_boost_intrusive_pool steals at once from another shard
+#define BOOST_INTRUSIVE_POOL_SHARD_STEAL_BATCH (32)
+#endif
+
+#ifndef BOOST_INTRUSIVE_POOL_CACHE_LINE_SIZE
+// used to avoid false sharing between data structures modified by different CPUs
+#define BOOST_INTRUSIVE_POOL_CACHE_LINE_SIZE (64)
+#endif
+
+#ifndef BOOST_INTRUSIVE_POOL_GROWTH_MAX_STEP
+// default maximum number of items added by a single enlarge step by boost_intrusive_pool_geometric_growth and
+// boost_intrusive_pool_adaptive_growth
+#define BOOST_INTRUSIVE_POOL_GROWTH_MAX_STEP (1024 * 1024)
+#endif
+
+#ifndef BOOST_INTRUSIVE_POOL_SEGMENT_SIZE
+// arenas are made of segments of this size (in bytes), aligned at their own size: the memory pool owning an item is
+// found by masking the address of the item. Must be a power of two and large enough to contain at least one item.
+#define BOOST_INTRUSIVE_POOL_SEGMENT_SIZE (64 * 1024)
+#endif
+
+#ifndef BOOST_INTRUSIVE_POOL_MAX_NUMA_NODES
+// maximum number of NUMA nodes the arenas can be bound to: arenas on nodes with higher ids are left unbound.
+// Must be a multiple of 64.
+#define BOOST_INTRUSIVE_POOL_MAX_NUMA_NODES (64)
+#endif
+
+#ifndef BOOST_INTRUSIVE_POOL_OCCUPANCY_BUCKETS
+// number of occupancy classes used by boost_intrusive_pool to find quickly the fullest arena having free items
+#define BOOST_INTRUSIVE_POOL_OCCUPANCY_BUCKETS (8)
+#endif
+
+#ifndef BOOST_INTRUSIVE_POOL_HUGE_PAGE_SIZE
+// size (in bytes) of the huge pages used by the arenas of memory pools created with MEMORY_BACKING_HUGE_PAGES:
+// their size is rounded up to a multiple of this value. Must be a power of two.
+#define BOOST_INTRUSIVE_POOL_HUGE_PAGE_SIZE (2 * 1024 * 1024)
+#endif
+
 //------------------------------------------------------------------------------
 // Start of memorypool namespace
 //------------------------------------------------------------------------------
@@ -65,45 +151,467 @@ typedef enum {
                                      // boost_intrusive_pool_item::destroy() virtual func
     RECYCLE_METHOD_CUSTOM_FUNCTION, // when an item returns into the pool, invoke a function provided at boost memory
                                     // pool init time
-    // RECYCLE_METHOD_DTOR,
+    RECYCLE_METHOD_DTOR, // when an item returns into the pool, invoke its dtor: free items are just raw storage and
+                         // the ctor of the item runs each time it is allocated (see allocate_through_init()); this
+                         // allows pooling items without a default ctor. Must be chosen at construction time.
 } recycle_method_e;
 
+// The following values can be combined together, e.g. MEMORY_BACKING_HUGE_PAGES | MEMORY_BACKING_LOCKED
+typedef enum {
+    MEMORY_BACKING_DEFAULT = 0, // arenas are allocated from the heap
+    MEMORY_BACKING_HUGE_PAGES = 1, // arenas are allocated from huge pages, to reduce TLB misses when accessing many
+                                   // items; if huge pages are not available, this silently falls back to the heap
+    MEMORY_BACKING_PREFAULT = 2, // the memory of each arena is touched as soon as the arena is allocated, so that the
+                                 // page faults happen inside enlarge() rather than during the following allocations
+    MEMORY_BACKING_LOCKED = 4, // like MEMORY_BACKING_PREFAULT, and the memory of each arena is locked with mlock()
+                               // so that it cannot be swapped out; if the RLIMIT_MEMLOCK limit does not allow that,
+                               // the memory is silently left unlocked
+    MEMORY_BACKING_NUMA_LOCAL = 8, // the memory of each arena is bound with mbind() to the NUMA node of the thread
+                                   // enlarging the memory pool; on machines (or kernels) without NUMA support, the
+                                   // memory is silently left unbound
+} memory_backing_e;
+
+inline memory_backing_e operator|(memory_backing_e a, memory_backing_e b)
+{
+    return (memory_backing_e)((int)a | (int)b);
+}
+
 //------------------------------------------------------------------------------
 // Forward declarations
 //------------------------------------------------------------------------------
 
 class boost_intrusive_pool_item;
+class boost_intrusive_pool_compact_item;
+
+//------------------------------------------------------------------------------
+// Refcount policies for boost_intrusive_pool_item and boost_intrusive_pool_compact_item
+// These mirror boost::thread_unsafe_counter and boost::thread_safe_counter.
+// To select the policy of a memory-pooled class, declare inside it:
+//    typedef memorypool::boost_intrusive_pool_thread_safe_counter boost_intrusive_pool_counter_policy;
+//------------------------------------------------------------------------------
+
+typedef std::atomic<size_t> boost_intrusive_pool_refcount_t;
+typedef std::atomic<uint32_t> boost_intrusive_pool_compact_refcount_t;
+
+// The default policy: the refcount of an item must be modified by one thread at a time, exactly like
+// a boost::intrusive_ref_counter<T, boost::thread_unsafe_counter>.
+// NOTE: relaxed atomic loads/stores compile to plain loads/stores, so this is as fast as a plain size_t counter
+struct boost_intrusive_pool_thread_unsafe_counter {
+    template <typename T> static void increment(std::atomic<T>& counter) noexcept
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    // returns the new value of the counter
+    template <typename T> static T decrement(std::atomic<T>& counter) noexcept
+    {
+        T new_value = counter.load(std::memory_order_relaxed) - 1;
+        counter.store(new_value, std::memory_order_relaxed);
+        return new_value;
+    }
+};
+
+// The policy for items shared among threads through boost::intrusive_ptr<>: copies of the same pointer can be
+// created and destroyed concurrently by any thread.
+struct boost_intrusive_pool_thread_safe_counter {
+    template <typename T> static void increment(std::atomic<T>& counter) noexcept
+    {
+        // a new reference can only be created from an existing one, so no ordering is required here
+        counter.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // returns the new value of the counter
+    template <typename T> static T decrement(std::atomic<T>& counter) noexcept
+    {
+        // release: all accesses to the item happen-before its recycle;
+        // acquire: the thread recycling the item sees all those accesses
+        return counter.fetch_sub(1, std::memory_order_acq_rel) - 1;
+    }
+};
+
+//------------------------------------------------------------------------------
+// Growth policies
+// A growth policy decides how many items are added by each enlarge step of a memory pool which ran out of free items.
+// To select the policy of a memory pool, invoke e.g.:
+//    pool.set_growth_policy(memorypool::boost_intrusive_pool_geometric_growth());
+// Any function object taking a boost_intrusive_pool_growth_info and returning the size of the step can be used.
+// Function objects declaring "static constexpr bool uses_elapsed_time = false" get no m_elapsed, which spares the
+// memory pool from reading the clock at each enlarge step.
+//------------------------------------------------------------------------------
+
+// What a growth policy knows about the memory pool being enlarged
+struct boost_intrusive_pool_growth_info {
+    size_t m_enlarge_size; // the "enlarge_size" provided at construction time
+    size_t m_capacity; // the current capacity of the memory pool
+    size_t m_enlarge_steps; // the number of enlarge steps done so far, including the initial allocation
+    size_t m_last_enlarge_size; // the number of items added by the last enlarge step (or by the initial allocation)
+    std::chrono::steady_clock::duration m_elapsed; // the time elapsed since the last enlarge step, if used
+};
+
+typedef std::function<size_t(const boost_intrusive_pool_growth_info&)> boost_intrusive_pool_growth_function;
+
+// The default policy: each enlarge step adds "enlarge_size" items
+struct boost_intrusive_pool_fixed_growth {
+    static constexpr bool uses_elapsed_time = false;
+
+    size_t operator()(const boost_intrusive_pool_growth_info& info) const { return info.m_enlarge_size; }
+};
+
+// Each enlarge step adds twice the items added by the previous one, starting from "enlarge_size" and up to
+// "max_step": the number of enlarge steps grows only logarithmically with the capacity of the memory pool
+class boost_intrusive_pool_geometric_growth {
+public:
+    static constexpr bool uses_elapsed_time = false;
+
+    boost_intrusive_pool_geometric_growth(size_t max_step = BOOST_INTRUSIVE_POOL_GROWTH_MAX_STEP)
+        : m_max_step(max_step)
+    {
+    }
+
+    size_t operator()(const boost_intrusive_pool_growth_info& info) const
+    {
+        if (info.m_enlarge_steps <= 1)
+            return info.m_enlarge_size; // the last step was the initial allocation
+        return std::max(info.m_enlarge_size, std::min(2 * info.m_last_enlarge_size, m_max_step));
+    }
+
+private:
+    size_t m_max_step;
+};
+
+// Each enlarge step adds the items expected to be needed during the next "horizon", estimated from the rate at which
+// the items added by the last enlarge step have been consumed; the step is at least "enlarge_size" and at most
+// "max_step". As long as the memory pool runs out of items faster than "horizon", each step is larger than the
+// previous one, so that the number of enlarge steps grows only logarithmically during allocation bursts.
+class boost_intrusive_pool_adaptive_growth {
+public:
+    boost_intrusive_pool_adaptive_growth(std::chrono::steady_clock::duration horizon = std::chrono::milliseconds(100),
+        size_t max_step = BOOST_INTRUSIVE_POOL_GROWTH_MAX_STEP)
+        : m_horizon(horizon)
+        , m_max_step(max_step)
+    {
+    }
+
+    size_t operator()(const boost_intrusive_pool_growth_info& info) const
+    {
+        double step = (double)m_max_step;
+        if (info.m_elapsed.count() > 0)
+            step = std::min(step,
+                (double)info.m_last_enlarge_size * (double)m_horizon.count() / (double)info.m_elapsed.count());
+        return std::max(info.m_enlarge_size, (size_t)step);
+    }
+
+private:
+    std::chrono::steady_clock::duration m_horizon;
+    size_t m_max_step;
+};
+
+// Detects whether a growth policy uses boost_intrusive_pool_growth_info::m_elapsed: all of them do, unless they
+// declare otherwise
+template <typename GrowthPolicy> struct boost_intrusive_pool_growth_uses_elapsed_time {
+    template <typename T> static std::integral_constant<bool, T::uses_elapsed_time> test(int);
+    template <typename T> static std::true_type test(...);
+
+    static constexpr bool value = decltype(test<GrowthPolicy>(0))::value;
+};
+
+// Internal helper class for all memory pools: the growth policy of a memory pool and the state it needs.
+// NOTE: this is not thread-safe: concurrent memory pools protect it with the mutex protecting their enlarge steps
+class boost_intrusive_pool_growth_state {
+public:
+    boost_intrusive_pool_growth_state()
+    {
+        m_last_enlarge_size = 0;
+        m_uses_elapsed_time = false;
+    }
+
+    void set_policy(boost_intrusive_pool_growth_function policy, bool uses_elapsed_time)
+    {
+        m_policy = policy;
+        m_uses_elapsed_time = m_policy && uses_elapsed_time;
+        if (m_uses_elapsed_time)
+            m_last_enlarge_time = std::chrono::steady_clock::now();
+    }
+    const boost_intrusive_pool_growth_function& get_policy() const { return m_policy; }
+    bool uses_elapsed_time() const { return m_uses_elapsed_time; }
+
+    // Returns the number of items to add with the next enlarge step (never zero)
+    size_t get_next_step(size_t enlarge_size, size_t capacity, size_t enlarge_steps) const
+    {
+        if (!m_policy)
+            return enlarge_size; // fixed growth
+
+        boost_intrusive_pool_growth_info info;
+        info.m_enlarge_size = enlarge_size;
+        info.m_capacity = capacity;
+        info.m_enlarge_steps = enlarge_steps;
+        info.m_last_enlarge_size = m_last_enlarge_size;
+        info.m_elapsed = std::chrono::steady_clock::duration::zero();
+        if (m_uses_elapsed_time)
+            info.m_elapsed = std::chrono::steady_clock::now() - m_last_enlarge_time;
+        return std::max<size_t>(m_policy(info), 1);
+    }
+
+    // Invoked after each enlarge step, including the initial allocation
+    void enlarged(size_t count)
+    {
+        m_last_enlarge_size = count;
+        if (m_uses_elapsed_time)
+            m_last_enlarge_time = std::chrono::steady_clock::now();
+    }
+
+private:
+    boost_intrusive_pool_growth_function m_policy;
+    bool m_uses_elapsed_time; // true if m_policy needs m_last_enlarge_time
+    size_t m_last_enlarge_size;
+    std::chrono::steady_clock::time_point m_last_enlarge_time;
+};
+
+//------------------------------------------------------------------------------
+// NUMA placement
+// The memory of the arenas can be bound to a NUMA node by the mbind() system call, which is invoked directly since
+// glibc provides no wrapper for it (libnuma does).
+//------------------------------------------------------------------------------
+
+// Returns the NUMA node of the CPU running the calling thread, or -1 if unknown
+inline int boost_intrusive_pool_get_current_numa_node()
+{
+#if defined(__linux__) && defined(SYS_getcpu)
+    unsigned int cpu, node;
+    if (syscall(SYS_getcpu, &cpu, &node, nullptr) == 0)
+        return (int)node;
+#endif
+    return -1;
+}
+
+// Binds the given memory, which must be page-aligned and must not share its pages with other allocations, to the given
+// NUMA node: its pages are allocated on that node when touched, and the pages already touched are moved there.
+// Returns false if the memory cannot be bound, e.g. because the kernel has no NUMA support or the node does not exist.
+inline bool boost_intrusive_pool_bind_numa_node(void* p, size_t size, int node)
+{
+#if defined(__linux__) && defined(SYS_mbind)
+    const int k_mpol_bind = 2; // MPOL_BIND from <numaif.h>
+    const unsigned int k_mpol_mf_move = 2; // MPOL_MF_MOVE from <numaif.h>
+    const int k_bits = 8 * sizeof(unsigned long);
+    if (node < 0 || node >= BOOST_INTRUSIVE_POOL_MAX_NUMA_NODES)
+        return false;
+    unsigned long nodemask[BOOST_INTRUSIVE_POOL_MAX_NUMA_NODES / k_bits] = {};
+    nodemask[node / k_bits] = 1UL << (node % k_bits);
+    // NOTE: the kernel reads one bit less than the given number of nodes
+    return syscall(SYS_mbind, p, size, k_mpol_bind, nodemask, BOOST_INTRUSIVE_POOL_MAX_NUMA_NODES + 1, k_mpol_mf_move)
+        == 0;
+#else
+    (void)p;
+    (void)size;
+    (void)node;
+    return false;
+#endif
+}
+
+// Returns the NUMA node the given memory is bound to, or -1 if it is not bound to a single node
+inline int boost_intrusive_pool_get_numa_node_of(void* p)
+{
+#if defined(__linux__) && defined(SYS_get_mempolicy)
+    const int k_mpol_bind = 2; // MPOL_BIND from <numaif.h>
+    const unsigned long k_mpol_f_addr = 2; // MPOL_F_ADDR from <numaif.h>
+    const int k_bits = 8 * sizeof(unsigned long);
+    int mode;
+    unsigned long nodemask[BOOST_INTRUSIVE_POOL_MAX_NUMA_NODES / k_bits] = {};
+    if (syscall(SYS_get_mempolicy, &mode, nodemask, BOOST_INTRUSIVE_POOL_MAX_NUMA_NODES + 1, p, k_mpol_f_addr) != 0
+        || mode != k_mpol_bind)
+        return -1;
+    int node = -1;
+    for (int i = 0; i < BOOST_INTRUSIVE_POOL_MAX_NUMA_NODES; i++) {
+        if (nodemask[i / k_bits] & (1UL << (i % k_bits))) {
+            if (node >= 0)
+                return -1; // the memory is bound to several nodes
+            node = i;
+        }
+    }
+    return node;
+#else
+    (void)p;
+    return -1;
+#endif
+}
+
+// Maps "size" bytes of anonymous memory aligned to "alignment" (a power of two), whose pages are not shared with
+// other allocations unlike the ones of the heap; returns NULL if no memory is available.
+// The memory must be released by boost_intrusive_pool_unmap().
+inline void* boost_intrusive_pool_map(size_t size, size_t alignment)
+{
+#ifdef __linux__
+    size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+    size = (size + page_size - 1) & ~(page_size - 1);
+    alignment = std::max(alignment, page_size);
+
+    // map more memory than needed, then unmap the excess on both sides of the aligned block
+    size_t mapped_size = size + alignment - page_size;
+    void* p = mmap(nullptr, mapped_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED)
+        return nullptr;
+    char* start = (char*)p;
+    char* aligned = (char*)(((uintptr_t)start + alignment - 1) & ~(uintptr_t)(alignment - 1));
+    if (aligned > start)
+        munmap(start, aligned - start);
+    if (aligned + size < start + mapped_size)
+        munmap(aligned + size, start + mapped_size - (aligned + size));
+    return aligned;
+#else
+    void* p = nullptr;
+    return (posix_memalign(&p, alignment, size) == 0) ? p : nullptr;
+#endif
+}
+
+inline void boost_intrusive_pool_unmap(void* p, size_t size)
+{
+#ifdef __linux__
+    munmap(p, size);
+#else
+    (void)size;
+    free(p);
+#endif
+}
+
+//------------------------------------------------------------------------------
+// Memory sources
+// A memory source provides the memory of the arenas of a memory pool in place of the heap (and of huge pages), e.g. to
+// place the memory pool on NUMA-local memory or inside a region preallocated at startup. The memory source must
+// outlive the memory pool and all the items allocated out of it.
+//------------------------------------------------------------------------------
+
+class boost_intrusive_pool_memory_source {
+public:
+    virtual ~boost_intrusive_pool_memory_source() {}
+
+    // Returns "size" bytes of memory aligned to "alignment" (a power of two), or NULL if no memory is available
+    virtual void* allocate_bytes(size_t size, size_t alignment) = 0;
+
+    // Gives back the memory returned by allocate_bytes() with the same size and alignment
+    virtual void deallocate_bytes(void* p, size_t size, size_t alignment) = 0;
+};
+
+#ifdef BOOST_INTRUSIVE_POOL_HAVE_PMR
+// Takes the memory of the arenas from a std::pmr::memory_resource (C++17)
+class boost_intrusive_pool_pmr_memory_source : public boost_intrusive_pool_memory_source {
+public:
+    boost_intrusive_pool_pmr_memory_source(std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : m_resource(resource)
+    {
+    }
+
+    void* allocate_bytes(size_t size, size_t alignment) override
+    {
+        try {
+            return m_resource->allocate(size, alignment);
+        } catch (const std::bad_alloc&) {
+            return nullptr;
+        }
+    }
+
+    void deallocate_bytes(void* p, size_t size, size_t alignment) override
+    {
+        m_resource->deallocate(p, size, alignment);
+    }
+
+private:
+    std::pmr::memory_resource* m_resource;
+};
+#endif
+
+// Takes the memory of the arenas from anonymous memory bound to the given NUMA node, e.g. to keep the items of a memory
+// pool close to the CPUs of a socket; on machines (or kernels) without NUMA support the memory is left unbound.
+// Use MEMORY_BACKING_NUMA_LOCAL instead to bind each arena to the node of the thread enlarging the memory pool.
+class boost_intrusive_pool_numa_memory_source : public boost_intrusive_pool_memory_source {
+public:
+    boost_intrusive_pool_numa_memory_source(int node)
+        : m_node(node)
+    {
+    }
+
+    void* allocate_bytes(size_t size, size_t alignment) override
+    {
+        void* p = boost_intrusive_pool_map(size, alignment);
+        if (p)
+            boost_intrusive_pool_bind_numa_node(p, size, m_node);
+        return p;
+    }
+
+    void deallocate_bytes(void* p, size_t size, size_t) override { boost_intrusive_pool_unmap(p, size); }
+
+    int get_numa_node() const { return m_node; }
+
+private:
+    int m_node;
+};
 
 //------------------------------------------------------------------------------
 // boost_intrusive_pool_iface
 //------------------------------------------------------------------------------
 
+// NOTE: items do not hold any reference to their pool: the refcount of the pool itself is modified only by the
+//       memory pool wrappers and, once the wrapper is gone, by the thread recycling the last item in use. It is
+//       thread-safe since that can be any thread.
 class boost_intrusive_pool_iface
-    : public boost::intrusive_ref_counter<boost_intrusive_pool_iface, boost::thread_unsafe_counter> {
+    : public boost::intrusive_ref_counter<boost_intrusive_pool_iface, boost::thread_safe_counter> {
 public:
     virtual ~boost_intrusive_pool_iface() = default;
 
     virtual void recycle(boost_intrusive_pool_item* item) = 0;
 
+    // only boost_intrusive_pool<> can contain items deriving from boost_intrusive_pool_compact_item
+    virtual void recycle_compact(boost_intrusive_pool_compact_item* item)
+    {
+        (void)item;
+        std::abort();
+    }
+
     virtual bool is_bounded() const = 0;
     virtual bool is_memory_exhausted() const = 0;
 };
 
+typedef boost::intrusive_ptr<boost_intrusive_pool_iface> boost_intrusive_pool_iface_ptr;
+
+//------------------------------------------------------------------------------
+// boost_intrusive_pool_segment
+// Internal helper class for all memory pools.
+//------------------------------------------------------------------------------
+
+// The memory of an arena is made of one or more segments of BOOST_INTRUSIVE_POOL_SEGMENT_SIZE bytes, aligned at their
+// own size. Each segment starts with this header, followed by as many items as fit in the rest of the segment; the
+// header of the segment containing an item is found just by masking the address of the item.
+struct boost_intrusive_pool_segment {
+    static_assert((BOOST_INTRUSIVE_POOL_SEGMENT_SIZE & (BOOST_INTRUSIVE_POOL_SEGMENT_SIZE - 1)) == 0,
+        "BOOST_INTRUSIVE_POOL_SEGMENT_SIZE must be a power of two");
+
+    boost_intrusive_pool_iface* m_owner; // the memory pool owning all items of this segment
+    void* m_arena; // the boost_intrusive_pool_arena containing this segment
+    uint32_t m_index; // the position of this segment among all segments of the memory pool (compact items only)
+};
+
+inline boost_intrusive_pool_segment* boost_intrusive_pool_segment_of(const void* pitem)
+{
+    return reinterpret_cast<boost_intrusive_pool_segment*>(
+        reinterpret_cast<uintptr_t>(pitem) & ~(uintptr_t)(BOOST_INTRUSIVE_POOL_SEGMENT_SIZE - 1));
+}
+
 //------------------------------------------------------------------------------
 // boost_intrusive_pool_item
 // Base class for any C++ class that will be used inside a boost_intrusive_pool
 //------------------------------------------------------------------------------
 
 class boost_intrusive_pool_item {
-    friend void intrusive_ptr_add_ref(boost_intrusive_pool_item* x);
-    friend void intrusive_ptr_release(boost_intrusive_pool_item* x);
-
 public:
+    // the refcount policy used by boost::intrusive_ptr<> for this class;
+    // derived classes can override this typedef to choose another policy
+    typedef boost_intrusive_pool_thread_unsafe_counter boost_intrusive_pool_counter_policy;
+
     boost_intrusive_pool_item()
     {
-        m_boost_intrusive_pool_next = nullptr;
-        m_boost_intrusive_pool_refcount = 0;
-        m_boost_intrusive_pool_owner = nullptr;
+        _refcounted_item_set_next(nullptr);
+        m_boost_intrusive_pool_refcount.store(0, std::memory_order_relaxed);
+        m_boost_intrusive_pool_shard = 0;
+        m_boost_intrusive_pool_pooled = 0;
     }
     boost_intrusive_pool_item(const boost_intrusive_pool_item& other)
     {
@@ -112,9 +620,10 @@ public:
         //   whether "this" instance is inside a memory pool or not, that has to stay that way,
         //   regardless of whether "other" is inside a memory pool or not.
 
-        m_boost_intrusive_pool_next = nullptr;
-        m_boost_intrusive_pool_refcount = 0;
-        m_boost_intrusive_pool_owner = nullptr;
+        _refcounted_item_set_next(nullptr);
+        m_boost_intrusive_pool_refcount.store(0, std::memory_order_relaxed);
+        m_boost_intrusive_pool_shard = 0;
+        m_boost_intrusive_pool_pooled = 0;
     }
     boost_intrusive_pool_item(const boost_intrusive_pool_item&& other)
     {
@@ -123,9 +632,10 @@ public:
         //   whether "this" instance is inside a memory pool or not, that has to stay that way,
         //   regardless of whether "other" is inside a memory pool or not.
 
-        m_boost_intrusive_pool_next = nullptr;
-        m_boost_intrusive_pool_refcount = 0;
-        m_boost_intrusive_pool_owner = nullptr;
+        _refcounted_item_set_next(nullptr);
+        m_boost_intrusive_pool_refcount.store(0, std::memory_order_relaxed);
+        m_boost_intrusive_pool_shard = 0;
+        m_boost_intrusive_pool_pooled = 0;
     }
     virtual ~boost_intrusive_pool_item() { }
 
@@ -133,7 +643,10 @@ public:
     // emulate the boost::intrusive_ref_counter class implementation:
     //------------------------------------------------------------------------------
 
-    unsigned int use_count() const noexcept { return m_boost_intrusive_pool_refcount; }
+    unsigned int use_count() const noexcept
+    {
+        return m_boost_intrusive_pool_refcount.load(std::memory_order_relaxed);
+    }
 
     boost_intrusive_pool_item& operator=(const boost_intrusive_pool_item& other)
     {
@@ -158,16 +671,38 @@ public:
     // memorypool::boost_intrusive_pool private functions
     //------------------------------------------------------------------------------
 
-    boost_intrusive_pool_item* _refcounted_item_get_next() { return m_boost_intrusive_pool_next; }
-    void _refcounted_item_set_next(boost_intrusive_pool_item* p) { m_boost_intrusive_pool_next = p; }
+    // NOTE: relaxed atomic accesses compile to plain loads/stores; the atomicity is only needed by the lock-free
+    //       free list of concurrent_boost_intrusive_pool, which may read the "next" pointer of an item concurrently
+    //       being popped by another thread
+    boost_intrusive_pool_item* _refcounted_item_get_next() const
+    {
+        return m_boost_intrusive_pool_next.load(std::memory_order_relaxed);
+    }
+    void _refcounted_item_set_next(boost_intrusive_pool_item* p)
+    {
+        m_boost_intrusive_pool_next.store(p, std::memory_order_relaxed);
+    }
 
-    boost::intrusive_ptr<boost_intrusive_pool_iface> _refcounted_item_get_pool()
+    // the memory pool owning an item is found from the address of the item (see boost_intrusive_pool_segment)
+    boost_intrusive_pool_iface* _refcounted_item_get_pool() const
     {
-        return m_boost_intrusive_pool_owner;
+        return is_in_memory_pool() ? boost_intrusive_pool_segment_of(this)->m_owner : nullptr;
     }
-    void _refcounted_item_set_pool(boost::intrusive_ptr<boost_intrusive_pool_iface> p)
+    void _refcounted_item_set_pooled(bool pooled) { m_boost_intrusive_pool_pooled = pooled ? 1 : 0; }
+
+    boost_intrusive_pool_refcount_t& _refcounted_item_get_refcount() { return m_boost_intrusive_pool_refcount; }
+
+    uint32_t _refcounted_item_get_shard() const { return m_boost_intrusive_pool_shard; }
+    void _refcounted_item_set_shard(uint32_t shard) { m_boost_intrusive_pool_shard = shard; }
+
+    // invoked when the refcount drops to zero
+    void _refcounted_item_dispose()
     {
-        m_boost_intrusive_pool_owner = p;
+        if (is_in_memory_pool())
+            boost_intrusive_pool_segment_of(this)->m_owner->recycle(this);
+        else
+            // assume the item has been allocated out of the pool:
+            delete this;
     }
 
     //------------------------------------------------------------------------------
@@ -185,200 +720,3212 @@ public:
     //  - this item lies unused in some memory pool
     // This function returns false if e.g. this item has been allocated on the heap
     // bypassing any memory pool mechanism.
-    bool is_in_memory_pool() const { return m_boost_intrusive_pool_owner != nullptr; }
+    bool is_in_memory_pool() const { return m_boost_intrusive_pool_pooled != 0; }
 
     // sanity checks for this item. Useful for debug only.
     void check() const
     {
         if (is_in_memory_pool()) {
-            assert(m_boost_intrusive_pool_refcount < BOOST_INTRUSIVE_POOL_DEBUG_MAX_REFCOUNT);
-
-            if (m_boost_intrusive_pool_refcount == 0) {
-                // this item is apparently inside the free list of the memory pool:
-                // in such case it should be always linked to the list; the only case where
-                // the "next" pointer can be NULL is in the case the memory pool is memory-bounded
-                // and the free items are exhausted or the memory pool is infinite but the memory is over
-                assert(m_boost_intrusive_pool_next != nullptr || m_boost_intrusive_pool_owner->is_bounded()
-                    || m_boost_intrusive_pool_owner->is_memory_exhausted());
+            assert(use_count() < BOOST_INTRUSIVE_POOL_DEBUG_MAX_REFCOUNT);
+
+            if (use_count() == 0) {
+                // this item is apparently inside the free list of the memory pool: its "next" pointer is NULL if
+                // it is the last item of the free list, which is empty as long as the pool can construct more items
+                // in the slots reserved by its last enlarge step
+                assert(_refcounted_item_get_pool() != nullptr);
             } else {
                 // this item is in use and thus must be UNLINKED from the free list of the memory pool:
-                assert(m_boost_intrusive_pool_next == nullptr);
+                assert(_refcounted_item_get_next() == nullptr);
             }
         }
     }
 
 private:
-    size_t m_boost_intrusive_pool_refcount; // intrusive refcount
-    boost_intrusive_pool_item* m_boost_intrusive_pool_next; // we use a free-list-based memory pool algorithm
-    boost::intrusive_ptr<boost_intrusive_pool_iface>
-        m_boost_intrusive_pool_owner; // used for auto-return to the memory pool
+    boost_intrusive_pool_refcount_t m_boost_intrusive_pool_refcount; // intrusive refcount
+    std::atomic<boost_intrusive_pool_item*>
+        m_boost_intrusive_pool_next; // we use a free-list-based memory pool algorithm
+    uint32_t m_boost_intrusive_pool_shard; // used by sharded_boost_intrusive_pool to return the item to its shard
+    uint32_t m_boost_intrusive_pool_pooled; // non-zero if this item lies in the arena of some memory pool
 };
 
-inline void intrusive_ptr_add_ref(boost_intrusive_pool_item* x)
+// NOTE: these are templates so that the refcount policy is chosen at compile time from the static type
+//       of the boost::intrusive_ptr<>, i.e. Item::boost_intrusive_pool_counter_policy
+
+template <typename Item>
+inline typename std::enable_if<std::is_base_of<boost_intrusive_pool_item, Item>::value>::type intrusive_ptr_add_ref(
+    Item* x)
 {
 #if BOOST_INTRUSIVE_POOL_DEBUG_CHECKS
-    assert(x->m_boost_intrusive_pool_refcount < BOOST_INTRUSIVE_POOL_DEBUG_MAX_REFCOUNT - 1);
+    assert(x->use_count() < BOOST_INTRUSIVE_POOL_DEBUG_MAX_REFCOUNT - 1);
 #endif
-    ++x->m_boost_intrusive_pool_refcount;
+    Item::boost_intrusive_pool_counter_policy::increment(x->_refcounted_item_get_refcount());
 }
 
-inline void intrusive_ptr_release(boost_intrusive_pool_item* x)
+template <typename Item>
+inline typename std::enable_if<std::is_base_of<boost_intrusive_pool_item, Item>::value>::type intrusive_ptr_release(
+    Item* x)
 {
 #if BOOST_INTRUSIVE_POOL_DEBUG_CHECKS
     x->check();
 #endif
-    if (--x->m_boost_intrusive_pool_refcount == 0) {
-        if (x->m_boost_intrusive_pool_owner)
-            x->m_boost_intrusive_pool_owner->recycle(x);
-        else
-            // assume the item has been allocated out of the pool:
-            delete x;
-    }
+    if (Item::boost_intrusive_pool_counter_policy::decrement(x->_refcounted_item_get_refcount()) == 0)
+        x->_refcounted_item_dispose();
 }
 
 //------------------------------------------------------------------------------
-// boost_intrusive_pool_arena
-// Internal helper class for a boost_intrusive_pool.
+// boost_intrusive_pool_compact_item
+// Alternative base class for C++ classes used inside a boost_intrusive_pool, with a smaller per-item overhead
 //------------------------------------------------------------------------------
 
-// Arena of items. This is just an array of items and a pointer
-// to another arena. All arenas are singly linked between them.
-template <typename Item> class boost_intrusive_pool_arena {
+// The header of a compact item is just 8 bytes: a 32-bit refcount and a 32-bit field holding either the index of
+// the next free item (while the item lies in the free list of its memory pool) or the state of the item.
+// There is no virtual table and no pointer to the owner pool, which is found from the address of the item
+// (see boost_intrusive_pool_segment).
+// Limitations:
+//  - compact items can be used only with boost_intrusive_pool<>, not with the concurrent or sharded memory pools;
+//  - a memory pool of compact items can contain at most about 4 billions items;
+//  - destroy() is not virtual: boost_intrusive_pool<Item> invokes Item::destroy();
+//  - since there is no virtual dtor, compact items allocated out of any memory pool must be released through
+//    a boost::intrusive_ptr<> of their exact type.
+class boost_intrusive_pool_compact_item {
 public:
-    // Creates an arena with arena_size items.
-    boost_intrusive_pool_arena(size_t arena_size, boost::intrusive_ptr<boost_intrusive_pool_iface> p)
-    {
-        assert(arena_size > 0 && p);
-        m_storage_size = arena_size;
-        m_storage = new Item[arena_size];
-        if (m_storage) {
-            for (size_t i = 1; i < arena_size; i++) {
-                m_storage[i - 1]._refcounted_item_set_next(&m_storage[i]);
-                m_storage[i - 1]._refcounted_item_set_pool(p);
-            }
-            m_storage[arena_size - 1]._refcounted_item_set_next(nullptr);
-            m_storage[arena_size - 1]._refcounted_item_set_pool(p);
-        }
-        // else: malloc failed!
+    // the refcount policy used by boost::intrusive_ptr<> for this class;
+    // derived classes can override this typedef to choose another policy
+    typedef boost_intrusive_pool_thread_unsafe_counter boost_intrusive_pool_counter_policy;
+
+    // special values of the "next" index
+    enum : uint32_t {
+        k_end_of_list = 0xFFFFFFFF, // this item is the last one of the free list
+        k_in_use = 0xFFFFFFFE, // this item has been allocated from its memory pool
+        k_not_pooled = 0xFFFFFFFD, // this item does not belong to any memory pool
+        k_max_items = 0xFFFFFFFD // all lower values are valid indexes
+    };
 
-        m_next_arena = nullptr;
+    boost_intrusive_pool_compact_item()
+    {
+        m_boost_intrusive_pool_refcount.store(0, std::memory_order_relaxed);
+        m_boost_intrusive_pool_next = k_not_pooled;
+    }
+    boost_intrusive_pool_compact_item(const boost_intrusive_pool_compact_item& other)
+    {
+        // IMPORTANT: see boost_intrusive_pool_item
+        m_boost_intrusive_pool_refcount.store(0, std::memory_order_relaxed);
+        m_boost_intrusive_pool_next = k_not_pooled;
+    }
+    boost_intrusive_pool_compact_item(const boost_intrusive_pool_compact_item&& other)
+    {
+        // IMPORTANT: see boost_intrusive_pool_item
+        m_boost_intrusive_pool_refcount.store(0, std::memory_order_relaxed);
+        m_boost_intrusive_pool_next = k_not_pooled;
     }
 
-    boost_intrusive_pool_arena(const boost_intrusive_pool_arena& other) = delete;
-    boost_intrusive_pool_arena(const boost_intrusive_pool_arena&& other) = delete;
+    //------------------------------------------------------------------------------
+    // emulate the boost::intrusive_ref_counter class implementation:
+    //------------------------------------------------------------------------------
 
-    ~boost_intrusive_pool_arena()
+    unsigned int use_count() const noexcept
     {
-        // m_storage is automatically cleaned up
-        if (m_storage) {
-            delete[] m_storage;
-            m_storage = nullptr;
-        }
+        return m_boost_intrusive_pool_refcount.load(std::memory_order_relaxed);
     }
 
-    // Returns a pointer to the array of items. This is used by the arena
-    // itself. This is only used to update free_list during initialization
-    // or when creating a new arena when the current one is full.
-    boost_intrusive_pool_item* get_first_item() const
+    boost_intrusive_pool_compact_item& operator=(const boost_intrusive_pool_compact_item& other)
     {
-        return dynamic_cast<boost_intrusive_pool_item*>(&m_storage[0]);
+        // IMPORTANT: see boost_intrusive_pool_item
+        return *this;
+    }
+    boost_intrusive_pool_compact_item& operator=(const boost_intrusive_pool_compact_item&& other)
+    {
+        // IMPORTANT: see boost_intrusive_pool_item
+        return *this;
     }
 
-    size_t get_stored_item_count() const { return m_storage_size; }
+    //------------------------------------------------------------------------------
+    // memorypool::boost_intrusive_pool private functions
+    //------------------------------------------------------------------------------
 
-    // Sets the next arena. Used when the current arena is full and
-    // we have created this one to get more storage.
-    void set_next_arena(boost_intrusive_pool_arena* p)
+    uint32_t _refcounted_item_get_next_index() const { return m_boost_intrusive_pool_next; }
+    void _refcounted_item_set_next_index(uint32_t index) { m_boost_intrusive_pool_next = index; }
+
+    boost_intrusive_pool_iface* _refcounted_item_get_pool() const
     {
-        assert(!m_next_arena && p);
-        m_next_arena = p;
-        m_storage[m_storage_size - 1]._refcounted_item_set_next(p->get_first_item());
+        return is_in_memory_pool() ? boost_intrusive_pool_segment_of(this)->m_owner : nullptr;
     }
-    boost_intrusive_pool_arena* get_next_arena() { return m_next_arena; }
-    const boost_intrusive_pool_arena* get_next_arena() const { return m_next_arena; }
 
-    boost_intrusive_pool_arena operator=(const boost_intrusive_pool_arena& other) = delete;
-    boost_intrusive_pool_arena operator=(const boost_intrusive_pool_arena&& other) = delete;
+    boost_intrusive_pool_compact_refcount_t& _refcounted_item_get_refcount() { return m_boost_intrusive_pool_refcount; }
+
+    //------------------------------------------------------------------------------
+    // default init-after-recycle, destroy-before-recycle methods:
+    //------------------------------------------------------------------------------
+
+    void destroy() { }
+
+    //------------------------------------------------------------------------------
+    // memorypool utility functions
+    //------------------------------------------------------------------------------
+
+    // see boost_intrusive_pool_item::is_in_memory_pool()
+    bool is_in_memory_pool() const { return m_boost_intrusive_pool_next != k_not_pooled; }
+
+    // sanity checks for this item. Useful for debug only.
+    void check() const
+    {
+        if (is_in_memory_pool()) {
+            assert(use_count() < BOOST_INTRUSIVE_POOL_DEBUG_MAX_REFCOUNT);
+
+            // an item in use must be UNLINKED from the free list of the memory pool and vice versa
+            assert((use_count() == 0) == (m_boost_intrusive_pool_next != k_in_use));
+        }
+    }
 
 private:
-    // Pointer to the next arena.
-    boost_intrusive_pool_arena* m_next_arena;
+    boost_intrusive_pool_compact_refcount_t m_boost_intrusive_pool_refcount; // intrusive refcount
+    uint32_t m_boost_intrusive_pool_next; // index of the next free item or one of the special values above
+};
+
+static_assert(sizeof(boost_intrusive_pool_compact_item) == 8, "the header of compact items must be 8 bytes");
+
+template <typename Item>
+inline typename std::enable_if<std::is_base_of<boost_intrusive_pool_compact_item, Item>::value>::type
+intrusive_ptr_add_ref(Item* x)
+{
+#if BOOST_INTRUSIVE_POOL_DEBUG_CHECKS
+    assert(x->use_count() < BOOST_INTRUSIVE_POOL_DEBUG_MAX_REFCOUNT - 1);
+#endif
+    Item::boost_intrusive_pool_counter_policy::increment(x->_refcounted_item_get_refcount());
+}
+
+template <typename Item>
+inline typename std::enable_if<std::is_base_of<boost_intrusive_pool_compact_item, Item>::value>::type
+intrusive_ptr_release(Item* x)
+{
+#if BOOST_INTRUSIVE_POOL_DEBUG_CHECKS
+    x->check();
+#endif
+    if (Item::boost_intrusive_pool_counter_policy::decrement(x->_refcounted_item_get_refcount()) == 0) {
+        if (x->is_in_memory_pool())
+            boost_intrusive_pool_segment_of(x)->m_owner->recycle_compact(x);
+        else
+            // assume the item has been allocated out of the pool:
+            delete x;
+    }
+}
+
+//------------------------------------------------------------------------------
+// boost_intrusive_pool_arena
+// Internal helper class for all memory pools.
+//------------------------------------------------------------------------------
+
+// Arena of items. This is the memory obtained with a single allocation, made of one or more segments
+// (see boost_intrusive_pool_segment), and a pointer to another arena. All arenas are singly linked between them.
+// Each time the memory pool is enlarged, some slots of an arena are reserved: the arena is shared by all enlarge steps
+// which fit into it, so that memory pools enlarged by small steps do not waste a whole segment for each step.
+// Reserved slots are turned into items only when they are needed, in the order of their addresses, so that the memory
+// pages of an arena are touched only when they are actually used.
+template <typename Item> class boost_intrusive_pool_occupancy_index;
+
+// Detects whether Base is a non-virtual base class of Derived, i.e. whether its offset is the same in all objects
+template <typename Derived, typename Base> struct boost_intrusive_pool_is_non_virtual_base {
+    template <typename T>
+    static auto test(int) -> decltype(static_cast<T*>(std::declval<Base*>()), std::true_type());
+    template <typename T> static std::false_type test(...);
+
+    static constexpr bool value = std::is_base_of<Base, Derived>::value && decltype(test<Derived>(0))::value;
+};
+
+template <typename Item> class boost_intrusive_pool_arena {
+public:
+    // The base class of the items: boost_intrusive_pool_item or boost_intrusive_pool_compact_item
+    using item_base = typename std::conditional<std::is_base_of<boost_intrusive_pool_compact_item, Item>::value,
+        boost_intrusive_pool_compact_item, boost_intrusive_pool_item>::type;
+
+    // the header of free slots is found through header_offset()
+    static_assert(boost_intrusive_pool_is_non_virtual_base<Item, item_base>::value,
+        "items of a memory pool must derive from boost_intrusive_pool_item or boost_intrusive_pool_compact_item "
+        "through non-virtual inheritance");
+
+    // Offset of the first item inside each segment and number of items contained in each segment
+    static constexpr size_t items_offset()
+    {
+        return (sizeof(boost_intrusive_pool_segment) + alignof(Item) - 1) / alignof(Item) * alignof(Item);
+    }
+    static constexpr size_t items_per_segment()
+    {
+        return (BOOST_INTRUSIVE_POOL_SEGMENT_SIZE - items_offset()) / sizeof(Item);
+    }
+
+    static_assert(BOOST_INTRUSIVE_POOL_SEGMENT_SIZE > items_offset() && items_per_segment() > 0,
+        "the items are too large: define BOOST_INTRUSIVE_POOL_SEGMENT_SIZE to a larger power of two");
+
+    // Creates an arena with room for at least min_capacity items, owned by the given memory pool; the segments of the
+    // arena are given consecutive indexes starting from first_segment_index. Its memory is taken from the given
+    // memory source, if any.
+    // Returns NULL if the memory allocation failed.
+    static boost_intrusive_pool_arena* create(size_t min_capacity, boost_intrusive_pool_iface* owner,
+        uint32_t first_segment_index, memory_backing_e backing = MEMORY_BACKING_DEFAULT,
+        boost_intrusive_pool_memory_source* source = nullptr)
+    {
+        assert(min_capacity > 0 && owner);
+        size_t segment_count = get_segment_count_for(min_capacity, backing);
+        size_t size = segment_count * BOOST_INTRUSIVE_POOL_SEGMENT_SIZE;
+        storage_kind_e kind = STORAGE_HEAP;
+        void* storage = nullptr;
+        if (source) {
+            storage = source->allocate_bytes(size, BOOST_INTRUSIVE_POOL_SEGMENT_SIZE);
+            if (!storage)
+                return nullptr; // the memory source is exhausted
+            assert((uintptr_t)storage % BOOST_INTRUSIVE_POOL_SEGMENT_SIZE == 0);
+            kind = STORAGE_SOURCE;
+        } else {
+            if (backing & MEMORY_BACKING_HUGE_PAGES)
+                storage = allocate_huge_pages(size, kind);
+            if (!storage && (backing & MEMORY_BACKING_NUMA_LOCAL)) {
+                // the pages of the heap may be shared with other allocations, which must not be bound
+                storage = boost_intrusive_pool_map(size, BOOST_INTRUSIVE_POOL_SEGMENT_SIZE);
+                if (storage)
+                    kind = STORAGE_MMAP;
+            }
+            if (!storage && posix_memalign(&storage, BOOST_INTRUSIVE_POOL_SEGMENT_SIZE, size) != 0)
+                return nullptr; // malloc failed!
+        }
+
+        // bind the memory before touching it, so that its pages are not moved afterwards
+        int numa_node = -1;
+        if (source) {
+            numa_node = boost_intrusive_pool_get_numa_node_of(storage);
+        } else if (backing & MEMORY_BACKING_NUMA_LOCAL) {
+            int node = boost_intrusive_pool_get_current_numa_node();
+            if (boost_intrusive_pool_bind_numa_node(storage, size, node))
+                numa_node = node;
+        }
+
+        bool locked = false;
+        if (backing & (MEMORY_BACKING_PREFAULT | MEMORY_BACKING_LOCKED))
+            locked = prefault((char*)storage, size, (backing & MEMORY_BACKING_LOCKED) != 0);
+
+        return new boost_intrusive_pool_arena(
+            owner, first_segment_index, (char*)storage, segment_count, kind, locked, numa_node, source);
+    }
+
+    // Returns the number of segments of an arena with room for at least the given number of items: arenas backed by
+    // huge pages are made of whole huge pages, so that no huge page is shared with other allocations
+    static size_t get_segment_count_for(size_t capacity, memory_backing_e backing = MEMORY_BACKING_DEFAULT)
+    {
+        size_t segment_count = (capacity + items_per_segment() - 1) / items_per_segment();
+        size_t segments_per_page = BOOST_INTRUSIVE_POOL_HUGE_PAGE_SIZE / BOOST_INTRUSIVE_POOL_SEGMENT_SIZE;
+        if ((backing & MEMORY_BACKING_HUGE_PAGES) && segments_per_page > 1)
+            segment_count = (segment_count + segments_per_page - 1) / segments_per_page * segments_per_page;
+        return segment_count;
+    }
+
+    boost_intrusive_pool_arena(const boost_intrusive_pool_arena& other) = delete;
+    boost_intrusive_pool_arena(const boost_intrusive_pool_arena&& other) = delete;
+
+    ~boost_intrusive_pool_arena()
+    {
+        if (!m_raw_slots) {
+            for (size_t i = 0; i < m_storage_size; i++)
+                get_item(i)->~Item();
+        }
+#ifdef __linux__
+        if (m_locked)
+            munlock(m_storage, get_memory_size()); // heap memory may be reused by someone else
+        if (m_storage_kind == STORAGE_HUGETLB) {
+            munmap(m_storage, m_segment_count * BOOST_INTRUSIVE_POOL_SEGMENT_SIZE);
+            return;
+        }
+#endif
+        if (m_storage_kind == STORAGE_MMAP) {
+            boost_intrusive_pool_unmap(m_storage, get_memory_size());
+            return;
+        }
+        if (m_storage_kind == STORAGE_SOURCE) {
+            m_memory_source->deallocate_bytes(m_storage, get_memory_size(), BOOST_INTRUSIVE_POOL_SEGMENT_SIZE);
+            return;
+        }
+        free(m_storage);
+    }
+
+    // Reserves "count" more slots of this arena, without touching their memory
+    void reserve_items(size_t count)
+    {
+        assert(count > 0 && count <= get_free_slot_count());
+        m_reserved_size += count;
+        m_reserve_steps++;
+    }
+
+    // Constructs "count" of the reserved slots which have not been used so far, linked together in a free list which
+    // is NULL-terminated (or terminated by k_end_of_list for compact items); returns the header of the first one.
+    // If "raw" is true, only the headers of the slots are constructed (see RECYCLE_METHOD_DTOR): this must be the
+    // same for all the slots of the arena.
+    item_base* construct_items(size_t count, bool raw = false)
+    {
+        assert(count > 0 && count <= get_pending_item_count());
+        assert(m_storage_size == 0 || m_raw_slots == raw);
+        m_raw_slots = raw;
+        size_t first = m_storage_size;
+        for (size_t i = first; i < first + count; i++) {
+            if (i % items_per_segment() == 0)
+                init_segment(i / items_per_segment()); // this is the first item of a segment
+            construct_slot(get_slot(i), raw, std::is_default_constructible<Item>());
+        }
+        m_storage_size += count;
+
+        link_items(first, std::is_base_of<boost_intrusive_pool_compact_item, Item>());
+        return header_of(get_slot(first));
+    }
+
+    // Reserves and constructs "count" more items at once
+    item_base* add_items(size_t count, bool raw = false)
+    {
+        reserve_items(count);
+        return construct_items(count, raw);
+    }
+
+    // Converts the address of a slot into the address of the header of the item it contains (i.e. its base class
+    // boost_intrusive_pool_item or boost_intrusive_pool_compact_item) and vice versa. Unlike static_cast<>, these
+    // do not require the item to be alive, as it happens to the free slots of memory pools using RECYCLE_METHOD_DTOR.
+    static item_base* header_of(Item* slot) { return reinterpret_cast<item_base*>((char*)slot + header_offset()); }
+    static Item* slot_of(item_base* header) { return reinterpret_cast<Item*>((char*)header - header_offset()); }
+
+    // Returns a pointer to the items of this arena. This is only used to update the free list
+    // during initialization or when enlarging the memory pool.
+    Item* get_item(size_t i) const
+    {
+        assert(i < m_storage_size);
+        return get_slot(i);
+    }
+    Item* get_last_item() const { return get_item(m_storage_size - 1); }
+    item_base* get_last_header() const { return header_of(get_slot(m_storage_size - 1)); }
+
+    // Returns the number of items constructed in this arena, the number of reserved slots not constructed yet and
+    // the number of slots that can still be reserved
+    size_t get_stored_item_count() const { return m_storage_size; }
+    size_t get_pending_item_count() const { return m_reserved_size - m_storage_size; }
+    size_t get_free_slot_count() const { return m_segment_count * items_per_segment() - m_reserved_size; }
+
+    // Returns the number of slots reserved so far and the number of enlarge steps which reserved them
+    size_t get_reserved_item_count() const { return m_reserved_size; }
+    size_t get_reserve_steps() const { return m_reserve_steps; }
+
+    // Counts the items of this arena which are currently in use: an arena whose items are all free can be released.
+    // NOTE: only boost_intrusive_pool keeps this counter updated
+    size_t get_inuse_count() const { return m_inuse_count; }
+    void add_inuse_items(size_t count) { m_inuse_count += count; }
+    void remove_inuse_items(size_t count)
+    {
+        assert(m_inuse_count >= count);
+        m_inuse_count -= count;
+    }
+
+    // Returns the number of items of this arena which can be allocated: the recycled ones plus the pending ones
+    size_t get_available_item_count() const { return m_reserved_size - m_inuse_count; }
+
+    // The list of recycled items of this arena; it never contains items of other arenas.
+    // NOTE: only boost_intrusive_pool keeps a free list for each arena; the items are linked by the memory pool
+    item_base* get_first_free_item() const { return m_first_free_item; }
+    void set_first_free_item(item_base* p) { m_first_free_item = p; }
+
+    // Returns the segments of this arena
+    uint32_t get_first_segment_index() const { return m_first_segment_index; }
+    size_t get_segment_count() const { return m_segment_count; }
+    size_t get_memory_size() const { return m_segment_count * BOOST_INTRUSIVE_POOL_SEGMENT_SIZE; }
+
+    // Returns true if the memory of this arena comes from explicit huge pages (MAP_HUGETLB) or has been advised to be
+    // backed by transparent huge pages (MADV_HUGEPAGE)
+    bool is_on_huge_pages() const { return m_storage_kind == STORAGE_HUGETLB || m_storage_kind == STORAGE_THP; }
+
+    // Returns true if the memory of this arena has been locked with mlock()
+    bool is_locked() const { return m_locked; }
+
+    // Returns the NUMA node the memory of this arena is bound to, or -1 if it is not bound to any node
+    int get_numa_node() const { return m_numa_node; }
+    char* get_segment(size_t i) const
+    {
+        assert(i < m_segment_count);
+        return m_storage + i * BOOST_INTRUSIVE_POOL_SEGMENT_SIZE;
+    }
+
+    // Sets the next arena. Used when the current arena is full and
+    // we have created this one to get more storage.
+    // NOTE: this only links the arenas together; the items of the new arena are linked to the free list
+    //       by the memory pool itself (arenas are always added when the free list is empty)
+    void set_next_arena(boost_intrusive_pool_arena* p)
+    {
+        assert(!m_next_arena && p);
+        m_next_arena = p;
+    }
+
+    // Unlinks the next arena, which is going to be released, from the list of arenas
+    void unlink_next_arena()
+    {
+        assert(m_next_arena);
+        m_next_arena = m_next_arena->m_next_arena;
+    }
+    boost_intrusive_pool_arena* get_next_arena() { return m_next_arena; }
+    const boost_intrusive_pool_arena* get_next_arena() const { return m_next_arena; }
+
+    boost_intrusive_pool_arena operator=(const boost_intrusive_pool_arena& other) = delete;
+    boost_intrusive_pool_arena operator=(const boost_intrusive_pool_arena&& other) = delete;
+
+private:
+    typedef enum {
+        STORAGE_HEAP, // posix_memalign()
+        STORAGE_HUGETLB, // mmap() with MAP_HUGETLB
+        STORAGE_THP, // posix_memalign() aligned to the huge page size, followed by madvise(MADV_HUGEPAGE)
+        STORAGE_SOURCE, // boost_intrusive_pool_memory_source::allocate_bytes()
+        STORAGE_MMAP, // boost_intrusive_pool_map()
+    } storage_kind_e;
+
+    boost_intrusive_pool_arena(boost_intrusive_pool_iface* owner, uint32_t first_segment_index, char* storage,
+        size_t segment_count, storage_kind_e kind, bool locked, int numa_node,
+        boost_intrusive_pool_memory_source* source)
+    {
+        m_next_arena = nullptr;
+        m_owner = owner;
+        m_first_segment_index = first_segment_index;
+        m_storage = storage;
+        m_storage_size = 0;
+        m_reserved_size = 0;
+        m_reserve_steps = 0;
+        m_inuse_count = 0;
+        m_first_free_item = nullptr;
+        m_segment_count = segment_count;
+        m_storage_kind = kind;
+        m_locked = locked;
+        m_numa_node = numa_node;
+        m_memory_source = source;
+        m_raw_slots = false;
+        m_index_prev = nullptr;
+        m_index_next = nullptr;
+        m_index_bucket = boost_intrusive_pool_occupancy_index<Item>::k_no_bucket;
+        m_index_min_inuse = 0;
+        m_index_max_inuse = 0;
+    }
+
+    // Tries to allocate "size" bytes from explicit huge pages first, then from transparent huge pages.
+    // Returns NULL if neither is available, so that the caller falls back to the heap.
+    static void* allocate_huge_pages(size_t size, storage_kind_e& kind)
+    {
+#if defined(__linux__) && defined(MAP_HUGETLB)
+        void* storage = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (storage != MAP_FAILED) {
+            if ((uintptr_t)storage % BOOST_INTRUSIVE_POOL_SEGMENT_SIZE == 0) {
+                kind = STORAGE_HUGETLB;
+                return storage;
+            }
+            munmap(storage, size); // segments must be aligned at their own size
+        }
+#endif
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+        void* aligned_storage = nullptr;
+        size_t alignment = std::max<size_t>(BOOST_INTRUSIVE_POOL_HUGE_PAGE_SIZE, BOOST_INTRUSIVE_POOL_SEGMENT_SIZE);
+        if (posix_memalign(&aligned_storage, alignment, size) == 0) {
+            if (madvise(aligned_storage, size, MADV_HUGEPAGE) == 0) {
+                kind = STORAGE_THP;
+                return aligned_storage;
+            }
+            free(aligned_storage); // transparent huge pages are disabled: the caller allocates with default alignment
+        }
+#endif
+        (void)size;
+        (void)kind;
+        return nullptr;
+    }
+
+    // Touches every page of the given memory so that the O.S. maps them right now, then locks them if requested.
+    // Returns true if the memory has been locked.
+    static bool prefault(char* storage, size_t size, bool lock)
+    {
+        // write to every page: reading could map all of them to the shared zero page
+        const size_t k_min_page_size = 4096;
+        for (size_t offset = 0; offset < size; offset += k_min_page_size)
+            *(volatile char*)(storage + offset) = 0;
+#ifdef __linux__
+        if (lock)
+            return mlock(storage, size) == 0;
+#endif
+        (void)lock;
+        return false;
+    }
+
+    void init_segment(size_t i)
+    {
+        boost_intrusive_pool_segment* segment = new (get_segment(i)) boost_intrusive_pool_segment;
+        segment->m_owner = m_owner;
+        segment->m_arena = this;
+        segment->m_index = m_first_segment_index + i;
+    }
+
+    Item* get_slot(size_t i) const
+    {
+        return reinterpret_cast<Item*>(m_storage + (i / items_per_segment()) * BOOST_INTRUSIVE_POOL_SEGMENT_SIZE
+            + items_offset() + (i % items_per_segment()) * sizeof(Item));
+    }
+
+    // Links the items from "first" to the last one; their owner is found through the segment header, so there is
+    // no need to store it inside each item
+    void link_items(size_t first, std::false_type /* compact */)
+    {
+        for (size_t i = first + 1; i < m_storage_size; i++) {
+            header_of(get_slot(i - 1))->_refcounted_item_set_next(header_of(get_slot(i)));
+            header_of(get_slot(i - 1))->_refcounted_item_set_pooled(true);
+        }
+        get_last_header()->_refcounted_item_set_next(nullptr);
+        get_last_header()->_refcounted_item_set_pooled(true);
+    }
+
+    // Links the compact items from "first" to the last one; the index of an item is the index of its segment
+    // times items_per_segment(), plus its position in the segment
+    void link_items(size_t first, std::true_type /* compact */)
+    {
+        size_t first_index = (size_t)m_first_segment_index * items_per_segment();
+        for (size_t i = first + 1; i < m_storage_size; i++)
+            header_of(get_slot(i - 1))->_refcounted_item_set_next_index(first_index + i);
+        get_last_header()->_refcounted_item_set_next_index(boost_intrusive_pool_compact_item::k_end_of_list);
+    }
+
+    // item_base is a non-virtual base class of Item, so its offset is the same for all items and can be computed on
+    // a slot which is never touched
+    static size_t header_offset()
+    {
+        static typename std::aligned_storage<sizeof(Item), alignof(Item)>::type probe_slot;
+        Item* probe = reinterpret_cast<Item*>(&probe_slot);
+        return (size_t)((char*)static_cast<item_base*>(probe) - (char*)probe);
+    }
+
+    static void construct_slot(Item* slot, bool raw, std::true_type /* default constructible */)
+    {
+        if (raw)
+            new (header_of(slot)) item_base;
+        else
+            new (slot) Item;
+    }
+    static void construct_slot(Item* slot, bool raw, std::false_type /* default constructible */)
+    {
+        // items without a default ctor are stored only by memory pools using RECYCLE_METHOD_DTOR
+        assert(raw);
+        (void)raw;
+        new (header_of(slot)) item_base;
+    }
+
+private:
+    // Pointer to the next arena.
+    boost_intrusive_pool_arena* m_next_arena;
+
+    // The memory pool owning this arena and the index of its first segment: the headers of the segments are
+    // initialized together with their first item
+    boost_intrusive_pool_iface* m_owner;
+    uint32_t m_first_segment_index;
+
+    // Storage of this arena.
+    char* m_storage;
+    size_t m_storage_size; // number of items constructed so far
+    size_t m_reserved_size; // number of slots reserved so far: slots after m_storage_size are not constructed yet
+    size_t m_reserve_steps; // number of reserve_items() calls so far
+    size_t m_inuse_count; // number of items currently in use
+    item_base* m_first_free_item;
+    size_t m_segment_count;
+    storage_kind_e m_storage_kind;
+    bool m_locked;
+    int m_numa_node; // -1 if the storage is not bound to a NUMA node
+    boost_intrusive_pool_memory_source* m_memory_source; // NULL unless the storage kind is STORAGE_SOURCE
+    bool m_raw_slots; // true if free slots contain just the header of an item (see RECYCLE_METHOD_DTOR)
+
+    // Position of this arena inside the boost_intrusive_pool_occupancy_index of its memory pool
+    friend class boost_intrusive_pool_occupancy_index<Item>;
+    boost_intrusive_pool_arena* m_index_prev;
+    boost_intrusive_pool_arena* m_index_next;
+    size_t m_index_bucket;
+    size_t m_index_min_inuse; // the occupancy of this arena matches its bucket if m_inuse_count is in
+    size_t m_index_max_inuse; // [m_index_min_inuse, m_index_max_inuse)
+};
+
+//------------------------------------------------------------------------------
+// boost_intrusive_pool_occupancy_index
+// Internal helper class for boost_intrusive_pool.
+//------------------------------------------------------------------------------
+
+// Index of the arenas of a memory pool having free items, by occupancy: the arenas are kept in
+// BOOST_INTRUSIVE_POOL_OCCUPANCY_BUCKETS doubly-linked lists according to the fraction of their items in use, so that
+// the fullest arena can be found in constant time.
+template <typename Item> class boost_intrusive_pool_occupancy_index {
+public:
+    using arena = boost_intrusive_pool_arena<Item>;
+
+    static constexpr size_t k_num_buckets = BOOST_INTRUSIVE_POOL_OCCUPANCY_BUCKETS;
+    static constexpr size_t k_no_bucket = ~(size_t)0; // the bucket of the arenas which are not in the index
+
+    static_assert(k_num_buckets > 0, "BOOST_INTRUSIVE_POOL_OCCUPANCY_BUCKETS must be positive");
+
+    boost_intrusive_pool_occupancy_index() { clear(); }
+
+    void clear()
+    {
+        for (size_t i = 0; i < k_num_buckets; i++)
+            m_buckets[i] = nullptr;
+    }
+
+    // Moves the arena into the bucket matching its occupancy, or removes it from the index if it has no free items.
+    // This is cheap when the occupancy of the arena has not crossed the boundaries of its bucket.
+    // NOTE: when the number of reserved items of an arena changes, it must be removed before invoking this
+    void update(arena* a)
+    {
+        if (a->m_inuse_count >= a->m_index_min_inuse && a->m_inuse_count < a->m_index_max_inuse)
+            return; // fast path: still in the right bucket
+
+        remove(a);
+        if (a->get_available_item_count() == 0)
+            return; // full arenas are not indexed
+
+        size_t reserved = a->get_reserved_item_count();
+        size_t bucket = a->m_inuse_count * k_num_buckets / reserved;
+        a->m_index_bucket = bucket;
+        a->m_index_min_inuse = (bucket * reserved + k_num_buckets - 1) / k_num_buckets;
+        a->m_index_max_inuse = ((bucket + 1) * reserved + k_num_buckets - 1) / k_num_buckets;
+
+        a->m_index_prev = nullptr;
+        a->m_index_next = m_buckets[bucket];
+        if (m_buckets[bucket])
+            m_buckets[bucket]->m_index_prev = a;
+        m_buckets[bucket] = a;
+    }
+
+    void remove(arena* a)
+    {
+        if (a->m_index_bucket == k_no_bucket)
+            return;
+
+        if (a->m_index_prev)
+            a->m_index_prev->m_index_next = a->m_index_next;
+        else
+            m_buckets[a->m_index_bucket] = a->m_index_next;
+        if (a->m_index_next)
+            a->m_index_next->m_index_prev = a->m_index_prev;
+
+        a->m_index_bucket = k_no_bucket;
+        a->m_index_min_inuse = a->m_index_max_inuse = 0; // forces the slow path of the next update()
+    }
+
+    bool contains(const arena* a) const { return a->m_index_bucket != k_no_bucket; }
+
+    // Removes from the index and returns the arena having the largest fraction of items in use; NULL if empty
+    arena* pop_fullest()
+    {
+        for (size_t i = k_num_buckets; i > 0; i--) {
+            arena* a = m_buckets[i - 1];
+            if (a) {
+                remove(a);
+                return a;
+            }
+        }
+        return nullptr;
+    }
+
+private:
+    arena* m_buckets[k_num_buckets];
+};
+
+//------------------------------------------------------------------------------
+// boost_intrusive_pool_downcast
+// Internal helper function for all memory pools.
+//------------------------------------------------------------------------------
+
+// Converts a pointer to an item of a memory pool back into the type of the items of that pool (base class -> derived
+// class). The arenas of a memory pool contain only items whose type is exactly Item, so a static_cast is always
+// correct and much cheaper than a dynamic_cast, especially with deep class hierarchies; RTTI is used only to
+// double check that when debug checks are active.
+template <typename Item> inline Item* boost_intrusive_pool_downcast(boost_intrusive_pool_item* pitem)
+{
+    static_assert(std::is_base_of<boost_intrusive_pool_item, Item>::value,
+        "items of a memory pool must derive from boost_intrusive_pool_item");
+
+    Item* ret = static_cast<Item*>(pitem);
+#if BOOST_INTRUSIVE_POOL_DEBUG_CHECKS
+    assert(dynamic_cast<Item*>(pitem) == ret);
+#endif
+    return ret;
+}
+
+// NOTE: compact items have no virtual table, hence no RTTI to double check this cast
+template <typename Item> inline Item* boost_intrusive_pool_downcast(boost_intrusive_pool_compact_item* pitem)
+{
+    return static_cast<Item*>(pitem);
+}
+
+//------------------------------------------------------------------------------
+// boost_intrusive_pool_construct
+// Internal helper functions for all memory pools.
+//------------------------------------------------------------------------------
+
+// The ctor of an item resets its header: these save and restore the part of the header which is meaningful while
+// the item is in use, i.e. the shard of boost_intrusive_pool_item (the fact that the item belongs to a memory pool is
+// implied) and the "in use" state of boost_intrusive_pool_compact_item.
+inline uint32_t boost_intrusive_pool_save_header(const boost_intrusive_pool_item* p)
+{
+    return p->_refcounted_item_get_shard();
+}
+inline void boost_intrusive_pool_restore_header(boost_intrusive_pool_item* p, uint32_t shard)
+{
+    p->_refcounted_item_set_pooled(true);
+    p->_refcounted_item_set_shard(shard);
+}
+inline uint32_t boost_intrusive_pool_save_header(const boost_intrusive_pool_compact_item* p)
+{
+    (void)p;
+    return 0;
+}
+inline void boost_intrusive_pool_restore_header(boost_intrusive_pool_compact_item* p, uint32_t)
+{
+    p->_refcounted_item_set_next_index(boost_intrusive_pool_compact_item::k_in_use);
+}
+
+// Detects whether Item has an init() member function accepting the given arguments
+template <typename Item, typename... Args> struct boost_intrusive_pool_has_init {
+    template <typename T>
+    static auto test(int) -> decltype(std::declval<T&>().init(std::declval<Args>()...), std::true_type());
+    template <typename T> static std::false_type test(...);
+
+    static constexpr bool value = decltype(test<Item>(0))::value;
+};
+
+template <typename Item, typename... Args>
+inline void boost_intrusive_pool_construct_in(std::true_type /* constructible */, Item* slot, Args&&... args)
+{
+    new (slot) Item(std::forward<Args>(args)...);
+}
+template <typename Item, typename... Args>
+inline void boost_intrusive_pool_construct_in(std::false_type /* constructible */, Item* slot, Args&&... args)
+{
+    // there is no ctor accepting these arguments: use the default ctor followed by init()
+    static_assert(std::is_default_constructible<Item>::value && boost_intrusive_pool_has_init<Item, Args&&...>::value,
+        "the item has neither a ctor nor an init() function accepting these arguments");
+    new (slot) Item;
+    slot->init(std::forward<Args>(args)...);
+}
+
+// Constructs an item inside a free slot handed out by a memory pool using RECYCLE_METHOD_DTOR, forwarding the
+// arguments to the ctor of the item or, if there is no such ctor, to the init() function of the item constructed by
+// its default ctor.
+template <typename Item, typename... Args> inline Item* boost_intrusive_pool_construct(Item* slot, Args&&... args)
+{
+    uint32_t header = boost_intrusive_pool_save_header(boost_intrusive_pool_arena<Item>::header_of(slot));
+    boost_intrusive_pool_construct_in(std::is_constructible<Item, Args&&...>(), slot, std::forward<Args>(args)...);
+    boost_intrusive_pool_restore_header(slot, header);
+    return slot;
+}
+
+template <typename Item, typename... Args>
+inline Item* boost_intrusive_pool_init_in(std::true_type /* default constructible */, Item* pitem, bool raw_slot,
+    Args&&... args)
+{
+    // the free items may be constructed already, so init() must accept the arguments
+    static_assert(boost_intrusive_pool_has_init<Item, Args&&...>::value,
+        "allocate_through_init() requires the item to have an init() function accepting its arguments");
+    if (raw_slot)
+        return boost_intrusive_pool_construct(pitem, std::forward<Args>(args)...);
+    pitem->init(std::forward<Args>(args)...);
+    return pitem;
+}
+template <typename Item, typename... Args>
+inline Item* boost_intrusive_pool_init_in(std::false_type /* default constructible */, Item* pitem, bool raw_slot,
+    Args&&... args)
+{
+    // items without a default ctor are stored only by memory pools using RECYCLE_METHOD_DTOR
+    static_assert(std::is_constructible<Item, Args&&...>::value,
+        "allocate_through_init() requires an item without a default ctor to have a ctor accepting its arguments");
+    assert(raw_slot);
+    (void)raw_slot;
+    return boost_intrusive_pool_construct(pitem, std::forward<Args>(args)...);
+}
+
+// Prepares an item handed out by a memory pool: pools using RECYCLE_METHOD_DTOR hand out free slots, where the item is
+// constructed from the arguments, while the other pools hand out items already constructed, whose init() function
+// gets the arguments.
+template <typename Item, typename... Args>
+inline Item* boost_intrusive_pool_init(Item* pitem, bool raw_slot, Args&&... args)
+{
+    return boost_intrusive_pool_init_in(
+        std::is_default_constructible<Item>(), pitem, raw_slot, std::forward<Args>(args)...);
+}
+
+// Destroys an item returning into a memory pool using RECYCLE_METHOD_DTOR: the slot is left with just the header of
+// the item, which is constructed again so that the memory pool can link the slot into its free list.
+template <typename Item> inline void boost_intrusive_pool_destroy(Item* pitem)
+{
+    typedef typename boost_intrusive_pool_arena<Item>::item_base item_base;
+    item_base* header = boost_intrusive_pool_arena<Item>::header_of(pitem);
+    uint32_t saved = boost_intrusive_pool_save_header(header);
+    pitem->~Item();
+    boost_intrusive_pool_restore_header(new (header) item_base, saved);
+}
+
+//------------------------------------------------------------------------------
+// Recycle policies
+// A recycle policy is the optional second template parameter of all memory pools: it selects at compile time what
+// the memory pool does with the items returning into it, so that the call is inlined without any branch or
+// std::function. A recycle policy is any default-constructible callable taking a reference to the item, e.g. the
+// closure type of a stateless lambda with C++20.
+//------------------------------------------------------------------------------
+
+// Does nothing with the items returning into the memory pool
+struct boost_intrusive_pool_no_recycle {
+    template <typename Item> void operator()(Item&) const { }
+};
+
+// Invokes the destroy() member function of the items returning into the memory pool; since the items of a memory pool
+// are exactly of type Item, the virtual function of boost_intrusive_pool_item is invoked without any virtual call
+struct boost_intrusive_pool_destroy_recycle {
+    template <typename Item> void operator()(Item& item) const { item.Item::destroy(); }
+};
+
+// Like boost_intrusive_pool_destroy_recycle if Item declares its own destroy() member function (or inherits it from
+// a class other than boost_intrusive_pool_item and boost_intrusive_pool_compact_item), otherwise does nothing
+struct boost_intrusive_pool_auto_recycle {
+    template <typename Item> void operator()(Item& item) const { recycle(item, declares_destroy<Item>()); }
+
+private:
+    // Detects whether destroy() can be invoked without arguments on Item
+    template <typename Item> struct has_destroy {
+        template <typename T> static auto test(int) -> decltype(std::declval<T&>().destroy(), std::true_type());
+        template <typename T> static std::false_type test(...);
+
+        static constexpr bool value = decltype(test<Item>(0))::value;
+    };
+
+    // Detects whether the destroy() function found in Item is the one of boost_intrusive_pool_item or
+    // boost_intrusive_pool_compact_item: if it is overloaded or a template, it has been declared by Item itself
+    template <typename Item> struct inherits_destroy {
+        template <typename T>
+        static auto test(int) -> std::integral_constant<bool,
+            std::is_same<decltype(&T::destroy), void (boost_intrusive_pool_item::*)()>::value
+                || std::is_same<decltype(&T::destroy), void (boost_intrusive_pool_compact_item::*)()>::value>;
+        template <typename T> static std::false_type test(...);
+
+        static constexpr bool value = decltype(test<Item>(0))::value;
+    };
+
+    template <typename Item>
+    using declares_destroy = std::integral_constant<bool, has_destroy<Item>::value && !inherits_destroy<Item>::value>;
+
+    template <typename Item> static void recycle(Item& item, std::true_type) { item.Item::destroy(); }
+    template <typename Item> static void recycle(Item&, std::false_type) { }
+};
+
+// Does what the recycle method and the recycle function given to the memory pool at runtime ask for: see
+// recycle_method_e. This is the default recycle policy, and the only one supporting RECYCLE_METHOD_DTOR.
+template <typename Item> class boost_intrusive_pool_runtime_recycle {
+public:
+    void configure(recycle_method_e method, const std::function<void(Item&)>& recycle_fn)
+    {
+        m_recycle_method = method;
+        m_recycle_fn = recycle_fn;
+    }
+
+    void operator()(Item& item) const
+    {
+        switch (m_recycle_method) {
+        case RECYCLE_METHOD_NONE:
+            break;
+
+        case RECYCLE_METHOD_DESTROY_FUNCTION:
+            item.destroy();
+            break;
+
+        case RECYCLE_METHOD_CUSTOM_FUNCTION:
+            m_recycle_fn(item);
+            break;
+
+        case RECYCLE_METHOD_DTOR:
+            boost_intrusive_pool_destroy(&item);
+            break;
+        }
+    }
+
+private:
+    recycle_method_e m_recycle_method = RECYCLE_METHOD_NONE;
+    std::function<void(Item&)> m_recycle_fn;
+};
+
+// Applies the recycle method and the recycle function given to a memory pool to its recycle policy: only the default
+// recycle policy can be configured at runtime
+template <typename Item>
+inline void boost_intrusive_pool_configure_recycle(boost_intrusive_pool_runtime_recycle<Item>& policy,
+    recycle_method_e method, const std::function<void(Item&)>& recycle_fn)
+{
+    policy.configure(method, recycle_fn);
+}
+template <typename RecyclePolicy, typename Item>
+inline void boost_intrusive_pool_configure_recycle(
+    RecyclePolicy&, recycle_method_e method, const std::function<void(Item&)>& recycle_fn)
+{
+    (void)method;
+    (void)recycle_fn;
+    assert(method == RECYCLE_METHOD_NONE && !recycle_fn); // the recycle policy is chosen at compile time
+}
+
+template <typename RecyclePolicy, typename Item>
+using boost_intrusive_pool_is_runtime_recycle
+    = std::is_same<RecyclePolicy, boost_intrusive_pool_runtime_recycle<Item>>;
+
+//------------------------------------------------------------------------------
+// boost_intrusive_pool_lockfree_stack
+// Internal helper class for a concurrent_boost_intrusive_pool.
+//------------------------------------------------------------------------------
+
+// Lock-free LIFO of free items (a Treiber stack) threaded through the same "next" pointer
+// used by the free list of the single-threaded memory pool.
+// The head pointer is packed together with a version counter inside a single machine word which
+// is updated with a compare-and-swap: every update of the head increments the version, so that a thread
+// preempted between reading the head and its compare-and-swap cannot be fooled by the head item being
+// popped and pushed back in the meantime (the so-called ABA problem).
+// On 64-bit platforms user-space addresses usually fit in 48 bits so the version is stored in the upper 16 bits;
+// on 32-bit platforms a 64-bit word is used, with a 32-bit version.
+// Memory pools refuse to grow with arenas whose addresses do not fit in 48 bits (see can_hold()), as it happens
+// with 5-level paging or with hardware pointer tagging.
+// The version wraps around every 65536 updates of the head: the ABA problem can still happen if a thread gets
+// preempted between reading the head and its compare-and-swap for exactly a multiple of 65536 updates, and finds the
+// same item on top of the stack. This is considered unlikely enough.
+class boost_intrusive_pool_lockfree_stack {
+public:
+    boost_intrusive_pool_lockfree_stack() { m_head.store(0); }
+
+    boost_intrusive_pool_lockfree_stack(const boost_intrusive_pool_lockfree_stack& other) = delete;
+    boost_intrusive_pool_lockfree_stack& operator=(const boost_intrusive_pool_lockfree_stack& other) = delete;
+
+    bool empty() const { return get_ptr(m_head.load(std::memory_order_acquire)) == nullptr; }
+
+    // Returns true if the addresses of the given memory fit in the bits of the head reserved to the pointer, so that
+    // the items stored in it can be pushed into the stack.
+    static bool can_hold(const void* storage, size_t size)
+    {
+        return ((tagged_ptr_t)((uintptr_t)storage + size - 1) & ~k_ptr_mask) == 0;
+    }
+
+    void push(boost_intrusive_pool_item* item) { push_chain(item, item); }
+
+    // Pushes a chain of items, already linked together through their "next" pointer starting from "first"
+    // and ending with "last", using a single compare-and-swap.
+    void push_chain(boost_intrusive_pool_item* first, boost_intrusive_pool_item* last)
+    {
+        assert(first && last);
+        tagged_ptr_t old_head = m_head.load(std::memory_order_relaxed);
+        tagged_ptr_t new_head;
+        do {
+            last->_refcounted_item_set_next(get_ptr(old_head));
+            new_head = make_tagged_ptr(first, get_tag(old_head) + 1);
+        } while (!m_head.compare_exchange_weak(old_head, new_head)); // seq_cst: see concurrent_boost_intrusive_pool
+    }
+
+    boost_intrusive_pool_item* pop()
+    {
+        size_t count;
+        return pop_chain(1, count);
+    }
+
+    // Detaches up to max_count items from the top of the stack using a single compare-and-swap.
+    // Returns the first item of the detached chain (NULL if the stack is empty); the chain is NULL-terminated and
+    // "count" is set to the number of items it contains.
+    boost_intrusive_pool_item* pop_chain(size_t max_count, size_t& count)
+    {
+        assert(max_count > 0);
+        tagged_ptr_t old_head = m_head.load(std::memory_order_acquire);
+        while (true) {
+            boost_intrusive_pool_item* first = get_ptr(old_head);
+            if (first == nullptr) {
+                count = 0;
+                return nullptr;
+            }
+
+            // NOTE: while we walk the chain, other threads might pop and modify these items: in such case the
+            //       compare-and-swap below fails since the version of the head has changed. This walk never touches
+            //       invalid memory since arenas are never released while the memory pool is alive.
+            boost_intrusive_pool_item* last = first;
+            count = 1;
+            while (count < max_count) {
+                boost_intrusive_pool_item* next = last->_refcounted_item_get_next();
+                if (next == nullptr)
+                    break;
+                last = next;
+                count++;
+            }
+
+            tagged_ptr_t new_head = make_tagged_ptr(last->_refcounted_item_get_next(), get_tag(old_head) + 1);
+            if (m_head.compare_exchange_weak(old_head, new_head, std::memory_order_acquire)) {
+                last->_refcounted_item_set_next(nullptr);
+                return first;
+            }
+        }
+    }
+
+    // Returns the number of items in the stack.
+    // NOTE: the result is reliable only if no other thread is modifying the stack at the same time.
+    size_t unsafe_size() const
+    {
+        size_t count = 0;
+        for (const boost_intrusive_pool_item* p = get_ptr(m_head.load()); p; p = p->_refcounted_item_get_next())
+            count++;
+        return count;
+    }
+
+    // Detaches the whole content of the stack; returns a NULL-terminated chain of items.
+    boost_intrusive_pool_item* pop_all()
+    {
+        tagged_ptr_t old_head = m_head.load(std::memory_order_relaxed);
+        while (!m_head.compare_exchange_weak(old_head, make_tagged_ptr(nullptr, get_tag(old_head) + 1)))
+            ; // seq_cst: see concurrent_boost_intrusive_pool
+        return get_ptr(old_head);
+    }
+
+private:
+    typedef uint64_t tagged_ptr_t;
+
+    static const unsigned int k_tag_shift = (sizeof(void*) == 8) ? 48 : 32;
+    static const tagged_ptr_t k_ptr_mask = (((tagged_ptr_t)1) << k_tag_shift) - 1;
+
+    static tagged_ptr_t make_tagged_ptr(boost_intrusive_pool_item* p, tagged_ptr_t tag)
+    {
+        assert(((tagged_ptr_t)(uintptr_t)p & ~k_ptr_mask) == 0); // the address must fit in the pointer bits
+        return (tagged_ptr_t)(uintptr_t)p | (tag << k_tag_shift);
+    }
+    static boost_intrusive_pool_item* get_ptr(tagged_ptr_t v)
+    {
+        return reinterpret_cast<boost_intrusive_pool_item*>((uintptr_t)(v & k_ptr_mask));
+    }
+    static tagged_ptr_t get_tag(tagged_ptr_t v) { return v >> k_tag_shift; }
+
+private:
+    std::atomic<tagged_ptr_t> m_head;
+};
+
+//------------------------------------------------------------------------------
+// boost_intrusive_pool_magazine
+// Internal helper class for a concurrent_boost_intrusive_pool.
+//------------------------------------------------------------------------------
+
+// A magazine is a small per-thread LIFO of free items belonging to a single concurrent_boost_intrusive_pool.
+// Items are linked through their "next" pointer, just like in the free list of the pool.
+class boost_intrusive_pool_magazine {
+public:
+    typedef void (*flush_function)(boost_intrusive_pool_magazine& magazine);
+
+    boost_intrusive_pool_magazine()
+    {
+        m_owner = nullptr;
+        m_flush_fn = nullptr;
+        m_first = nullptr;
+        m_count = 0;
+    }
+
+    void push(boost_intrusive_pool_item* item)
+    {
+        item->_refcounted_item_set_next(m_first);
+        m_first = item;
+        m_count++;
+    }
+
+    boost_intrusive_pool_item* pop()
+    {
+        assert(m_count > 0);
+        boost_intrusive_pool_item* item = m_first;
+        m_first = item->_refcounted_item_get_next();
+        item->_refcounted_item_set_next(nullptr);
+        m_count--;
+        return item;
+    }
+
+public:
+    // The pool owning all items in this magazine.
+    // Items in a magazine are counted as in use, so the pool stays alive as long as this magazine is not empty;
+    // when the magazine is empty this pointer might refer to a pool that does not exist anymore (and whose address
+    // might have been reused by another pool, possibly of another type: that is why m_flush_fn is compared too).
+    const boost_intrusive_pool_iface* m_owner;
+
+    // The function to call to give back all items to the owner pool
+    flush_function m_flush_fn;
+
+    boost_intrusive_pool_item* m_first;
+    size_t m_count;
+};
+
+// The set of magazines of the calling thread: all magazines still holding items are flushed when the thread exits.
+class boost_intrusive_pool_thread_cache {
+public:
+    ~boost_intrusive_pool_thread_cache()
+    {
+        for (size_t i = 0; i < BOOST_INTRUSIVE_POOL_MAX_THREAD_MAGAZINES; i++)
+            if (m_magazines[i].m_count > 0)
+                m_magazines[i].m_flush_fn(m_magazines[i]);
+    }
+
+    // Returns the magazine of the calling thread for the given pool; if "create" is true and the pool has no magazine
+    // yet, a magazine is assigned to it. Returns NULL if the pool has no magazine and none can be assigned.
+    static boost_intrusive_pool_magazine* get_magazine(
+        const boost_intrusive_pool_iface* owner, boost_intrusive_pool_magazine::flush_function flush_fn, bool create)
+    {
+        static thread_local boost_intrusive_pool_thread_cache tc;
+
+        boost_intrusive_pool_magazine* unused = nullptr;
+        for (size_t i = 0; i < BOOST_INTRUSIVE_POOL_MAX_THREAD_MAGAZINES; i++) {
+            boost_intrusive_pool_magazine& m = tc.m_magazines[i];
+            if (m.m_owner == owner && m.m_flush_fn == flush_fn)
+                return &m;
+            if (m.m_count == 0 && unused == nullptr)
+                unused = &m; // this magazine is empty: it can be reassigned
+        }
+
+        if (!create || unused == nullptr)
+            return nullptr;
+
+        unused->m_owner = owner;
+        unused->m_flush_fn = flush_fn;
+        return unused;
+    }
+
+private:
+    boost_intrusive_pool_magazine m_magazines[BOOST_INTRUSIVE_POOL_MAX_THREAD_MAGAZINES];
+};
+
+//------------------------------------------------------------------------------
+// boost_intrusive_pool
+// The actual memory pool implementation.
+//------------------------------------------------------------------------------
+
+template <class Item, class RecyclePolicy = boost_intrusive_pool_runtime_recycle<Item>>
+class boost_intrusive_pool {
+public:
+    static_assert(std::is_base_of<boost_intrusive_pool_item, Item>::value
+            || std::is_base_of<boost_intrusive_pool_compact_item, Item>::value,
+        "items of a memory pool must derive from boost_intrusive_pool_item or boost_intrusive_pool_compact_item");
+    static_assert(std::is_default_constructible<Item>::value
+            || boost_intrusive_pool_is_runtime_recycle<RecyclePolicy, Item>::value,
+        "items without a default ctor require a memory pool using RECYCLE_METHOD_DTOR");
+
+    // The type of pointers provided by this memory pool implementation
+    using item_ptr = boost::intrusive_ptr<Item>;
+
+    // The base class of the items: boost_intrusive_pool_item or boost_intrusive_pool_compact_item
+    using item_base = typename std::conditional<std::is_base_of<boost_intrusive_pool_compact_item, Item>::value,
+        boost_intrusive_pool_compact_item, boost_intrusive_pool_item>::type;
+
+    // The allocate function type
+    // NOTE: allocate_through_function() accepts any callable taking a reference to the item: passing it directly
+    // rather than through this type avoids the heap allocation std::function does for callables not fitting its
+    // small buffer (e.g. lambdas with several captures)
+    using allocate_function = std::function<void(Item&)>;
+
+    // The recycle function type
+    // If specified the recycle function will be called every time a resource gets recycled into the pool. This allows
+    // temporary resources, e.g., file handles to be closed when an object is longer used.
+    using recycle_function = std::function<void(Item&)>;
+
+    // The growth policy type: see boost_intrusive_pool_growth_info
+    using growth_function = boost_intrusive_pool_growth_function;
+
+public:
+    // Default constructor
+    // Leaves this memory pool uninitialized. It's mandatory to invoke init() after this one.
+    boost_intrusive_pool() { m_pool = nullptr; }
+
+    // Constructs a memory pool quite small which increases its size by rather small steps.
+    // Tuning of these steps is critical for performances.
+    // The ctor also allows you to specify which function should be run on items returning to the pool, and where the
+    // memory of the arenas comes from: see memory_backing_e and boost_intrusive_pool_memory_source.
+    boost_intrusive_pool(size_t init_size, size_t enlarge_size = BOOST_INTRUSIVE_POOL_INCREASE_STEP,
+        size_t max_size = BOOST_INTRUSIVE_POOL_NO_MAX_SIZE, recycle_method_e recycle_method = RECYCLE_METHOD_NONE,
+        recycle_function recycle_fn = nullptr, memory_backing_e memory_backing = MEMORY_BACKING_DEFAULT,
+        boost_intrusive_pool_memory_source* memory_source = nullptr)
+    {
+        // NOTE: return value is ignored... if the software is out of memory... we can't do much within a ctor
+        init(init_size, enlarge_size, max_size, recycle_method, recycle_fn, memory_backing, memory_source);
+    }
+    // NOTE: the memory pool must be destroyed by its owner thread: that thread keeps recycling its items without
+    //       taking any lock until it sees the pool becoming orphan (see impl::trigger_self_destruction())
+    virtual ~boost_intrusive_pool()
+    {
+        if (m_pool) {
+            assert(m_pool->is_owner_thread());
+            m_pool->trigger_self_destruction();
+        }
+    }
+
+    // Copy constructor
+    boost_intrusive_pool(const boost_intrusive_pool& other) = delete;
+
+    // Move constructor
+    boost_intrusive_pool(boost_intrusive_pool&& other) = delete;
+
+    // Copy assignment
+    boost_intrusive_pool& operator=(const boost_intrusive_pool& other) = delete;
+
+    // Move assignment
+    boost_intrusive_pool& operator=(boost_intrusive_pool&& other) = delete;
+
+    //------------------------------------------------------------------------------
+    // configuration/initialization methods
+    //------------------------------------------------------------------------------
+
+    bool init(size_t init_size = BOOST_INTRUSIVE_POOL_DEFAULT_POOL_SIZE,
+        size_t enlarge_size = BOOST_INTRUSIVE_POOL_INCREASE_STEP, size_t max_size = BOOST_INTRUSIVE_POOL_NO_MAX_SIZE,
+        recycle_method_e recycle_method = RECYCLE_METHOD_NONE, recycle_function recycle_fn = nullptr,
+        memory_backing_e memory_backing = MEMORY_BACKING_DEFAULT,
+        boost_intrusive_pool_memory_source* memory_source = nullptr)
+    {
+        assert(m_pool == nullptr); // cannot initialize twice the memory pool
+        assert(init_size > 0);
+        assert((max_size == BOOST_INTRUSIVE_POOL_NO_MAX_SIZE) || (max_size >= init_size && enlarge_size > 0));
+
+        m_pool = boost::intrusive_ptr<impl>(
+            new impl(enlarge_size, max_size, recycle_method, recycle_fn, memory_backing, memory_source));
+
+        // do initial malloc
+        return m_pool->enlarge(init_size);
+    }
+
+    void set_recycle_method(recycle_method_e method, recycle_function recycle_fn = nullptr)
+    {
+        assert(m_pool); // pool must be initialized
+        m_pool->set_recycle_method(method, recycle_fn);
+    }
+
+    // Selects how many items each enlarge step adds to the pool: see boost_intrusive_pool_fixed_growth (the default),
+    // boost_intrusive_pool_geometric_growth and boost_intrusive_pool_adaptive_growth. The step is still limited by
+    // max_size, and bulk allocations may enlarge the pool by more items than the policy asks for.
+    template <typename GrowthPolicy> void set_growth_policy(GrowthPolicy growth_fn)
+    {
+        assert(m_pool); // pool must be initialized
+        m_pool->m_growth.set_policy(growth_fn, boost_intrusive_pool_growth_uses_elapsed_time<GrowthPolicy>::value);
+    }
+
+    // Hands this memory pool over to another thread. The thread which creates (or init()s) the pool owns it: only the
+    // owner can allocate items, trim, clear or destroy the pool, while any thread can release items.
+    // This must be invoked by the current owner, which afterwards can only release items like any other thread; the
+    // pool must then reach the new owner through some synchronization (a mutex, a queue, the start of a thread...).
+    void set_owner_thread(std::thread::id owner)
+    {
+        assert(m_pool); // pool must be initialized
+        assert(m_pool->is_owner_thread());
+        m_pool->set_owner_thread(owner);
+    }
+    std::thread::id get_owner_thread() const { return m_pool ? m_pool->get_owner_thread() : std::thread::id(); }
+
+    //------------------------------------------------------------------------------
+    // allocate method variants
+    //------------------------------------------------------------------------------
+
+    // Returns the first available free item.
+    item_ptr allocate()
+    {
+        assert(m_pool); // pool must be initialized
+        Item* recycled_item = m_pool->allocate_safe_get_recycled_item();
+        if (!recycled_item)
+            return nullptr;
+
+        // in this case we don't need to call ANY function, unless the free items are just raw storage
+        if (m_pool->has_raw_slots())
+            boost_intrusive_pool_construct(recycled_item);
+
+        item_ptr ret_ptr(recycled_item);
+#if BOOST_INTRUSIVE_POOL_DEBUG_CHECKS
+        ret_ptr->check();
+#endif
+        return ret_ptr;
+    }
+
+    // Returns first available free item or, if necessary and the memory pool is unbounded and has not reached the
+    // maximum size, allocates a new item. Uses C++11 perfect forwarding to the init() function of the memory pooled
+    // item.
+    template <typename... Args> item_ptr allocate_through_init(Args&&... args)
+    {
+        assert(m_pool); // pool must be initialized
+        Item* recycled_item = m_pool->allocate_safe_get_recycled_item();
+        if (!recycled_item)
+            return nullptr;
+
+        // Construct the object in the obtained storage using the init() method of the item itself or, if the free
+        // items are just raw storage, using its ctor:
+        boost_intrusive_pool_init(recycled_item, m_pool->has_raw_slots(), std::forward<Args>(args)...);
+
+        // AFTER the init() call, run the check() function
+        item_ptr ret_ptr(recycled_item);
+#if BOOST_INTRUSIVE_POOL_DEBUG_CHECKS
+        ret_ptr->check();
+#endif
+        return ret_ptr;
+    }
+
+    // Returns first available free item or, if necessary and the memory pool is unbounded,
+    // allocates a new item. The given callable is invoked directly (and can be inlined) on the item.
+    template <typename Function> item_ptr allocate_through_function(Function&& fn)
+    {
+        assert(m_pool); // pool must be initialized
+        Item* recycled_item = m_pool->allocate_safe_get_recycled_item();
+        if (!recycled_item)
+            return nullptr;
+
+        // the function runs on an item constructed by its default ctor, also when the free items are just raw storage
+        if (m_pool->has_raw_slots())
+            boost_intrusive_pool_construct(recycled_item);
+        fn(*recycled_item);
+
+        // relinking the item to the pool is instead a critical step: we just executed
+        // the ctor of the recycled item; that resulted in a call to
+        // boost_intrusive_pool_item::boost_intrusive_pool_item()!
+        m_pool->relink_item(recycled_item);
+
+        // AFTER the ctor call, run the check() function
+        item_ptr ret_ptr(recycled_item);
+#if BOOST_INTRUSIVE_POOL_DEBUG_CHECKS
+        ret_ptr->check();
+#endif
+        return ret_ptr;
+    }
+
+    //------------------------------------------------------------------------------
+    // bulk allocate method variants
+    // These detach up to n items from the free list in a single walk and enlarge the pool at most once.
+    // Each item is written as an item_ptr into the "out" output iterator; the return value is the number of items
+    // written, which can be less than n only if the memory pool is bounded, has reached its maximum size or
+    // memory is exhausted.
+    //------------------------------------------------------------------------------
+
+    template <typename OutputIt> size_t allocate_bulk(size_t n, OutputIt out)
+    {
+        assert(m_pool); // pool must be initialized
+        size_t count = 0;
+        item_base* pcurr = (n > 0) ? m_pool->allocate_safe_get_recycled_chain(n, count) : nullptr;
+        while (pcurr) {
+            Item* recycled_item = unlink_from_chain(pcurr);
+            if (m_pool->has_raw_slots())
+                boost_intrusive_pool_construct(recycled_item);
+
+            item_ptr ret_ptr(recycled_item);
+#if BOOST_INTRUSIVE_POOL_DEBUG_CHECKS
+            ret_ptr->check();
+#endif
+            *out++ = std::move(ret_ptr);
+        }
+        return count;
+    }
+
+    // NOTE: the same arguments are provided to the init() function of all items, so they are never moved.
+    template <typename OutputIt, typename... Args>
+    size_t allocate_bulk_through_init(size_t n, OutputIt out, Args&&... args)
+    {
+        assert(m_pool); // pool must be initialized
+        size_t count = 0;
+        item_base* pcurr = (n > 0) ? m_pool->allocate_safe_get_recycled_chain(n, count) : nullptr;
+        while (pcurr) {
+            Item* recycled_item = unlink_from_chain(pcurr);
+
+            boost_intrusive_pool_init(recycled_item, m_pool->has_raw_slots(), args...);
+
+            item_ptr ret_ptr(recycled_item);
+#if BOOST_INTRUSIVE_POOL_DEBUG_CHECKS
+            ret_ptr->check();
+#endif
+            *out++ = std::move(ret_ptr);
+        }
+        return count;
+    }
+
+    template <typename OutputIt, typename Function>
+    size_t allocate_bulk_through_function(size_t n, OutputIt out, Function&& fn)
+    {
+        assert(m_pool); // pool must be initialized
+        size_t count = 0;
+        item_base* pcurr = (n > 0) ? m_pool->allocate_safe_get_recycled_chain(n, count) : nullptr;
+        while (pcurr) {
+            Item* recycled_item = unlink_from_chain(pcurr);
+            if (m_pool->has_raw_slots())
+                boost_intrusive_pool_construct(recycled_item);
+
+            fn(*recycled_item);
+
+            // see allocate_through_function()
+            m_pool->relink_item(recycled_item);
+
+            item_ptr ret_ptr(recycled_item);
+#if BOOST_INTRUSIVE_POOL_DEBUG_CHECKS
+            ret_ptr->check();
+#endif
+            *out++ = std::move(ret_ptr);
+        }
+        return count;
+    }
+
+    //------------------------------------------------------------------------------
+    // bulk release
+    //------------------------------------------------------------------------------
+
+    // Releases all the item_ptr of the given range (e.g. a std::vector<item_ptr>), which are reset to NULL.
+    // The items of this pool whose refcount drops to zero are recycled all together: the recycle method runs on them
+    // in a tight loop and they are added to the free list at once, paying a single virtual call. Items belonging
+    // to other pools (or not belonging to any pool) are released as usual.
+    template <typename Range> void release_bulk(Range& items)
+    {
+        assert(m_pool); // pool must be initialized
+
+        item_base* first = nullptr;
+        item_base* last = nullptr;
+        size_t count = 0;
+        for (auto& ptr : items) {
+            Item* pitem = ptr.detach();
+            if (!pitem)
+                continue;
+            if (pitem->_refcounted_item_get_pool() != m_pool.get()) {
+                intrusive_ptr_release(pitem);
+                continue;
+            }
+
+#if BOOST_INTRUSIVE_POOL_DEBUG_CHECKS
+            pitem->check();
+#endif
+            if (Item::boost_intrusive_pool_counter_policy::decrement(pitem->_refcounted_item_get_refcount()) != 0)
+                continue; // this item is still referenced elsewhere
+
+            // add the item to the chain to recycle
+            m_pool->set_next(pitem, first);
+            if (!first)
+                last = pitem;
+            first = pitem;
+            count++;
+        }
+
+        if (count > 0)
+            m_pool->recycle_chain(first, last, count);
+    }
+
+    //------------------------------------------------------------------------------
+    // other functions operating on items
+    //------------------------------------------------------------------------------
+
+    void clear()
+    {
+        if (!m_pool)
+            return; // nothing to do
+
+        // VERY IMPORTANT: this function is very tricky: to do this correctly we cannot
+        // simply call m_pool->clear(): that would remove all arenas that are the memory
+        // support of memory pool items.
+        // At this point we don't know yet if there are boost::intrusive_ptr<> out there
+        // still alive... so we must play safe (and, like the dtor, run on the owner thread, which keeps owning the
+        // new pool):
+        assert(m_pool->is_owner_thread());
+        size_t init_size = m_pool->m_enlarge_step;
+        size_t enlarge_size = m_pool->m_enlarge_step;
+        size_t max_size = m_pool->m_max_size;
+        recycle_method_e method = m_pool->m_recycle_method;
+        RecyclePolicy recycle_policy = m_pool->m_recycle_policy;
+        memory_backing_e memory_backing = m_pool->m_memory_backing;
+        boost_intrusive_pool_memory_source* memory_source = m_pool->m_memory_source;
+        growth_function growth = m_pool->m_growth.get_policy();
+        bool growth_uses_elapsed_time = m_pool->m_growth.uses_elapsed_time();
+        m_pool->trigger_self_destruction();
+        m_pool = nullptr; // release old pool
+        m_pool = boost::intrusive_ptr<impl>(
+            new impl(enlarge_size, max_size, method, nullptr, memory_backing, memory_source));
+        m_pool->m_recycle_policy = recycle_policy;
+        m_pool->m_growth.set_policy(growth, growth_uses_elapsed_time);
+    }
+
+    // Releases the memory of the arenas whose items are all free, as long as at least "keep_free" free items are left
+    // in the pool; capacity() and enlarge_steps_done() decrease accordingly. Bounded memory pools are never trimmed.
+    // Returns the number of items released. Like allocations, this must be invoked by the thread owning the pool.
+    size_t trim(size_t keep_free) { return m_pool ? m_pool->trim(keep_free) : 0; }
+
+    // Releases the memory of all arenas whose items are all free
+    size_t shrink_to_fit() { return trim(0); }
+
+    void check()
+    {
+        if (!m_pool)
+            return; // nothing to do
+        m_pool->check();
+    }
+
+    //------------------------------------------------------------------------------
+    // getters
+    //------------------------------------------------------------------------------
+
+    // returns true if there are no elements in use.
+    // Note that if empty()==true, it does not mean that capacity()==0 as well!
+    bool empty() const { return m_pool ? m_pool->empty() : true; }
+
+    bool is_bounded() const { return m_pool ? m_pool->is_bounded() : false; }
+
+    bool is_limited() const { return m_pool ? m_pool->is_limited() : false; }
+
+    bool is_memory_exhausted() const { return m_pool ? m_pool->is_memory_exhausted() : false; }
+
+    // returns the current (=maximum) capacity of the object pool
+    size_t capacity() const { return m_pool ? m_pool->capacity() : 0; }
+
+    size_t max_size() const { return m_pool ? m_pool->max_size() : 0; }
+
+    // returns the number of free entries of the pool
+    size_t unused_count() const { return m_pool ? m_pool->unused_count() : 0; }
+
+    // returns the number of items currently malloc()ed from this pool
+    size_t inuse_count() const { return m_pool ? m_pool->inuse_count() : 0; }
+
+    // returns the number of enlarge steps done so far, excluding those whose arena has been released by trim()
+    size_t enlarge_steps_done() const { return m_pool ? m_pool->enlarge_steps_done() : 0; }
+
+    // returns the fraction of free items inside the arenas which cannot be released by trim() since they contain
+    // items in use: zero when the items in use are packed densely in as few arenas as possible
+    // NOTE: this walks all arenas of the pool
+    double fragmentation() const { return m_pool ? m_pool->fragmentation() : 0.0; }
+
+    // returns the number of bytes of arena memory obtained from huge pages: zero unless the pool has been created with
+    // MEMORY_BACKING_HUGE_PAGES and huge pages are available
+    size_t huge_page_memory() const { return m_pool ? m_pool->huge_page_memory() : 0; }
+
+    // returns the number of bytes of arena memory locked in RAM: zero unless the pool has been created with
+    // MEMORY_BACKING_LOCKED and the RLIMIT_MEMLOCK limit allows locking its arenas
+    size_t locked_memory() const { return m_pool ? m_pool->locked_memory() : 0; }
+
+    // returns the number of items whose memory is bound to the given NUMA node: zero unless the pool has been created
+    // with MEMORY_BACKING_NUMA_LOCAL or with a memory source binding its memory to that node (see
+    // boost_intrusive_pool_numa_memory_source) and the machine supports NUMA
+    size_t numa_node_capacity(int node) const { return m_pool ? m_pool->numa_node_capacity(node) : 0; }
+
+private:
+    // Unlinks the first item of a chain returned by impl::allocate_safe_get_recycled_chain() and advances
+    // "pcurr" to the next one.
+    Item* unlink_from_chain(item_base*& pcurr)
+    {
+        item_base* pitem = pcurr;
+        assert(pitem->_refcounted_item_get_pool() == m_pool.get());
+        pcurr = m_pool->get_next(pitem);
+        m_pool->set_in_use(pitem);
+        return m_pool->item_of(pitem);
+    }
+
+    /// The actual pool implementation. Pooled objects find it through
+    /// the header of the segment they lie in, so that they can add
+    /// themselves back into the pool once they go out of scope.
+    class impl : public boost_intrusive_pool_iface {
+    public:
+        impl(size_t enlarge_size, size_t max_size, recycle_method_e method, recycle_function recycle,
+            memory_backing_e memory_backing, boost_intrusive_pool_memory_source* memory_source)
+        {
+            // assert(enlarge_size > 0); // NOTE: enlarge_size can be zero to create a limited-size memory pool
+
+            // configurations
+            // items without a default ctor can be constructed only when they get allocated:
+            assert(std::is_default_constructible<Item>::value || method == RECYCLE_METHOD_DTOR);
+            m_recycle_method = std::is_default_constructible<Item>::value ? method : RECYCLE_METHOD_DTOR;
+            boost_intrusive_pool_configure_recycle(m_recycle_policy, m_recycle_method, recycle);
+            m_enlarge_step = enlarge_size;
+            m_max_size = max_size;
+            m_memory_backing = memory_backing;
+            m_memory_source = memory_source;
+
+            // status
+            m_alloc_arena = nullptr;
+            m_remote_free_list.store(null_link());
+            m_first_arena = nullptr;
+            m_last_arena = nullptr;
+            m_memory_exhausted = false;
+            m_trigger_self_destruction.store(false);
+            m_owner_thread.store(std::this_thread::get_id(), std::memory_order_relaxed);
+
+            // stats
+            m_free_count = 0;
+            m_inuse_count = 0;
+            m_total_count = 0;
+            m_enlarge_steps = 0;
+            m_huge_page_memory = 0;
+            m_locked_memory = 0;
+            std::fill(m_numa_capacity, m_numa_capacity + BOOST_INTRUSIVE_POOL_MAX_NUMA_NODES, 0);
+        }
+
+        ~impl()
+        {
+            // if this dtor is called, it means that all memory pooled items have been destroyed:
+            // m_orphan_reference is held on their behalf, so if one of them was alive, this dtor would not be called!
+            clear();
+        }
+
+        void set_recycle_method(recycle_method_e method, recycle_function recycle = nullptr)
+        {
+            // the arenas contain either constructed items or raw storage, depending on RECYCLE_METHOD_DTOR:
+            assert((method == RECYCLE_METHOD_DTOR) == has_raw_slots());
+            m_recycle_method = method;
+            boost_intrusive_pool_configure_recycle(m_recycle_policy, method, recycle);
+        }
+
+        // returns true if free items are just raw storage where items get constructed when they are allocated
+        bool has_raw_slots() const
+        {
+            return boost_intrusive_pool_is_runtime_recycle<RecyclePolicy, Item>::value
+                && m_recycle_method == RECYCLE_METHOD_DTOR;
+        }
+
+        void trigger_self_destruction()
+        {
+            // items do not hold a reference to this pool: from now on a single reference is held on behalf of all
+            // items still in use, and released by the last one returning to this pool (see recycle_orphan())
+            m_orphan_reference = this;
+            m_trigger_self_destruction.store(true);
+
+            boost_intrusive_pool_iface_ptr last_reference; // released after unlocking the mutex
+            {
+                std::lock_guard<std::mutex> lock(m_orphan_mutex);
+
+                // close the remote free list: threads which do not own this pool will recycle items through
+                // recycle_orphan() from now on; the items already pushed are recycled here
+                item_base* pcurr = from_link(m_remote_free_list.exchange(closed_link()));
+                while (pcurr) {
+                    item_base* pnext = get_next(pcurr);
+                    recycle_into_free_list(pcurr);
+                    pcurr = pnext;
+                }
+                if (m_inuse_count == 0)
+                    last_reference.swap(m_orphan_reference);
+            }
+        }
+
+        size_t get_effective_enlarge_step() const
+        {
+            if (m_enlarge_step == 0)
+                return 0;
+            size_t enlarge_step = m_growth.get_next_step(m_enlarge_step, m_total_count, m_enlarge_steps);
+            if (m_max_size > 0 && m_total_count + enlarge_step > m_max_size)
+                enlarge_step = m_max_size - m_total_count; // enlarge_step can be zero if we reach the max_size
+            return enlarge_step;
+        }
+
+        void check_owner_thread()
+        {
+#if BOOST_INTRUSIVE_POOL_DEBUG_THREAD_ACCESS
+            assert(is_owner_thread());
+#endif
+        }
+
+        Item* allocate_safe_get_recycled_item()
+        {
+            check_owner_thread();
+
+            if (m_free_count == 0)
+                drain_remote_free_list();
+            if (m_free_count == 0) {
+                size_t enlarge_step = get_effective_enlarge_step();
+                if (enlarge_step == 0 || !enlarge(enlarge_step)) {
+                    m_memory_exhausted = true;
+                    return nullptr; // allocation by enlarge() failed or this is a fixed-size memory pool!
+                }
+            }
+
+            // get first item from free list
+            item_base* pitem = pop_free_item();
+            assert(pitem->_refcounted_item_get_pool() == this); // this was set during arena initialization
+                                                                // and must be valid at all times
+
+            // update stats
+            m_free_count--;
+            m_inuse_count++;
+
+            refill_if_free_list_empty();
+
+            // unlink the item to return
+            set_in_use(pitem);
+            return item_of(pitem);
+        }
+
+        // Detaches up to max_count items from the free lists with a single walk, enlarging the pool at most once.
+        // Returns the first item of the detached chain (NULL if no item is available); the chain is NULL-terminated
+        // and "count" is set to the number of items it contains.
+        item_base* allocate_safe_get_recycled_chain(size_t max_count, size_t& count)
+        {
+            check_owner_thread();
+
+            if (m_free_count < max_count)
+                drain_remote_free_list();
+            if (m_free_count < max_count && m_enlarge_step > 0) {
+                // enlarge by at least one item more than what is missing, so that the free list will not be empty
+                // after detaching the chain (which would trigger another enlarge)
+                size_t enlarge_step = m_growth.get_next_step(m_enlarge_step, m_total_count, m_enlarge_steps);
+                enlarge_step = std::max(enlarge_step, max_count - m_free_count + 1);
+                if (m_max_size > 0 && m_total_count + enlarge_step > m_max_size)
+                    enlarge_step = m_max_size - m_total_count; // enlarge_step can be zero if we reach the max_size
+                if (enlarge_step == 0 || !enlarge(enlarge_step))
+                    m_memory_exhausted = true;
+            }
+
+            count = std::min(max_count, m_free_count);
+            if (count < max_count)
+                m_memory_exhausted = true; // allocation by enlarge() failed or this is a fixed-size memory pool!
+            if (count == 0)
+                return nullptr;
+
+            item_base* first = pop_free_items(count);
+
+            // update stats
+            m_free_count -= count;
+            m_inuse_count += count;
+
+            refill_if_free_list_empty();
+            return first;
+        }
+
+        // Detaches a free item of the arena chosen for allocations: recycled items come first, since they are likely
+        // to be hot in cache, then the slots reserved by enlarge() and never used so far are constructed.
+        // Must be invoked only if m_free_count > 0.
+        item_base* pop_free_item()
+        {
+            if (!m_alloc_arena || m_alloc_arena->get_available_item_count() == 0)
+                select_alloc_arena();
+
+            boost_intrusive_pool_arena<Item>* arena = m_alloc_arena;
+            item_base* pitem = arena->get_first_free_item();
+            if (pitem)
+                arena->set_first_free_item(get_next(pitem));
+            else
+                pitem = arena->construct_items(1, has_raw_slots());
+            arena->add_inuse_items(1);
+            return pitem;
+        }
+
+        // Detaches "count" free items like pop_free_item() does, moving to other arenas only once the arena chosen
+        // for allocations has no free items left. Returns the first item of the resulting NULL-terminated chain.
+        // Must be invoked only if m_free_count >= count.
+        item_base* pop_free_items(size_t count)
+        {
+            assert(count > 0 && count <= m_free_count);
+            item_base* first = nullptr;
+            item_base* last = nullptr;
+            while (count > 0) {
+                if (!m_alloc_arena || m_alloc_arena->get_available_item_count() == 0)
+                    select_alloc_arena();
+
+                boost_intrusive_pool_arena<Item>* arena = m_alloc_arena;
+                size_t n = std::min(count, arena->get_available_item_count());
+                arena->add_inuse_items(n);
+                count -= n;
+
+                // detach first the recycled items, then construct the missing ones
+                item_base* pitem = arena->get_first_free_item();
+                if (pitem) {
+                    if (first)
+                        set_next(last, pitem);
+                    else
+                        first = pitem;
+                    last = pitem;
+                    for (n--; n > 0 && (pitem = get_next(last)) != nullptr; n--)
+                        last = pitem;
+                    arena->set_first_free_item(get_next(last));
+                }
+                if (n > 0) {
+                    item_base* chain = arena->construct_items(n, has_raw_slots());
+                    if (first)
+                        set_next(last, chain);
+                    else
+                        first = chain;
+                    last = arena->get_last_header();
+                }
+            }
+
+            // unlink the chain to return
+            set_next(last, nullptr);
+            return first;
+        }
+
+        // Chooses the arena to allocate from, once the current one has no free items left: the fullest one, so that
+        // the items in use are packed in as few arenas as possible and the other arenas can become idle (see trim()).
+        void select_alloc_arena()
+        {
+            m_alloc_arena = m_occupancy_index.pop_fullest();
+            assert(m_alloc_arena); // m_free_count > 0: some arena has free items
+        }
+
+        // Invoked after detaching items from the free list.
+        void refill_if_free_list_empty()
+        {
+            if (m_free_count == 0)
+                drain_remote_free_list();
+            if (m_free_count == 0 && m_enlarge_step > 0) {
+                size_t enlarge_step = get_effective_enlarge_step();
+                if (enlarge_step == 0) { // enlarge_step can be zero if we reach the max_size
+                    m_memory_exhausted = true;
+                } else {
+                    // this is a memory pool which can be still enlarged:
+                    // exit the function leaving at least one free item!
+                    // this is just to simplify debugging and make more effective the check() function implementation!
+                    if (!enlarge(enlarge_step)) {
+                        m_memory_exhausted = true;
+                        // We tried to fetch memory from the O.S. but we failed. However we succeeded in getting the
+                        // last available items. So fallback and provide them to the caller.
+                    }
+                }
+            }
+        }
+
+        bool enlarge(size_t arena_size)
+        {
+            check_owner_thread();
+            // If the last arena has no room for the new items, create a new one.
+            if (!m_last_arena || m_last_arena->get_free_slot_count() < arena_size) {
+                // compact items are linked through 32-bit indexes: check that there are enough indexes left
+                size_t segment_count
+                    = boost_intrusive_pool_arena<Item>::get_segment_count_for(arena_size, m_memory_backing);
+                size_t first_segment_index = is_compact::value ? find_free_segment_indexes(segment_count) : 0;
+                if (is_compact::value
+                    && (first_segment_index + segment_count) * boost_intrusive_pool_arena<Item>::items_per_segment()
+                        > (size_t)boost_intrusive_pool_compact_item::k_max_items)
+                    return false;
+
+                boost_intrusive_pool_arena<Item>* new_arena = boost_intrusive_pool_arena<Item>::create(
+                    arena_size, this, first_segment_index, m_memory_backing, m_memory_source);
+                if (!new_arena)
+                    return false; // malloc failed... memory finished... very likely this is a game over
+                if (new_arena->is_on_huge_pages())
+                    m_huge_page_memory += new_arena->get_memory_size();
+                if (new_arena->is_locked())
+                    m_locked_memory += new_arena->get_memory_size();
+                if (is_compact::value) {
+                    assert(new_arena->get_segment_count() == segment_count);
+                    if (m_segments.size() < first_segment_index + segment_count)
+                        m_segments.resize(first_segment_index + segment_count, nullptr);
+                    for (size_t i = 0; i < segment_count; i++)
+                        m_segments[first_segment_index + i] = new_arena->get_segment(i);
+                }
+
+                // Link the new arena to the last one.
+                if (m_last_arena)
+                    m_last_arena->set_next_arena(new_arena);
+                if (m_first_arena == nullptr)
+                    m_first_arena = new_arena; // apparently we are initializing the memory pool for the very first time
+
+                // Seek pointer to last arena
+                m_last_arena = new_arena;
+            }
+
+            // Reserve the new items in the last arena: they will be constructed only when needed, after all the
+            // items reserved so far in that arena (see pop_free_item())
+            m_last_arena->reserve_items(arena_size);
+            if (m_last_arena->get_numa_node() >= 0)
+                m_numa_capacity[m_last_arena->get_numa_node()] += arena_size;
+            if (m_last_arena != m_alloc_arena) {
+                m_occupancy_index.remove(m_last_arena); // its occupancy has changed
+                m_occupancy_index.update(m_last_arena);
+            }
+
+            m_enlarge_steps++;
+            m_free_count += arena_size;
+            m_total_count += arena_size;
+            m_growth.enlarged(arena_size);
+
+            return true;
+        }
+
+        // Releases the arenas whose items are all free, as long as at least "keep_free" free items are left (and at
+        // least one while some items are in use, like after any allocation: see refill_if_free_list_empty()).
+        // Returns the number of items released.
+        size_t trim(size_t keep_free)
+        {
+            check_owner_thread();
+            if (is_bounded())
+                return 0; // a bounded memory pool could never get back the released items
+
+            drain_remote_free_list();
+            if (m_inuse_count > 0)
+                keep_free = std::max<size_t>(keep_free, 1);
+
+            // Unlink the idle arenas from the list of arenas
+            std::vector<boost_intrusive_pool_arena<Item>*> released;
+            size_t released_count = 0;
+            boost_intrusive_pool_arena<Item>* prev = nullptr;
+            boost_intrusive_pool_arena<Item>* pcurr = m_first_arena;
+            while (pcurr) {
+                boost_intrusive_pool_arena<Item>* pnext = pcurr->get_next_arena();
+                size_t count = pcurr->get_reserved_item_count();
+                if (pcurr->get_inuse_count() == 0 && m_free_count - released_count >= keep_free + count) {
+                    released.push_back(pcurr);
+                    released_count += count;
+                    if (prev)
+                        prev->unlink_next_arena();
+                    else
+                        m_first_arena = pnext;
+                    if (m_last_arena == pcurr)
+                        m_last_arena = prev;
+                } else {
+                    prev = pcurr;
+                }
+                pcurr = pnext;
+            }
+            if (released.empty())
+                return 0;
+
+            // Forget the released arenas: their free items are linked only in their own free lists
+            for (boost_intrusive_pool_arena<Item>* arena : released) {
+                m_occupancy_index.remove(arena);
+                if (arena == m_alloc_arena)
+                    m_alloc_arena = nullptr;
+                m_enlarge_steps -= arena->get_reserve_steps();
+                if (arena->is_on_huge_pages())
+                    m_huge_page_memory -= arena->get_memory_size();
+                if (arena->is_locked())
+                    m_locked_memory -= arena->get_memory_size();
+                if (arena->get_numa_node() >= 0)
+                    m_numa_capacity[arena->get_numa_node()] -= arena->get_reserved_item_count();
+                if (is_compact::value) {
+                    // no item links to the released segments anymore: their indexes can be given to new arenas
+                    for (size_t i = 0; i < arena->get_segment_count(); i++)
+                        m_segments[arena->get_first_segment_index() + i] = nullptr;
+                }
+            }
+            while (!m_segments.empty() && m_segments.back() == nullptr)
+                m_segments.pop_back();
+            m_free_count -= released_count;
+            m_total_count -= released_count;
+            m_memory_exhausted = false; // the memory pool can be enlarged again
+
+            for (boost_intrusive_pool_arena<Item>* arena : released)
+                delete arena;
+            return released_count;
+        }
+
+        // Returns the first of "count" consecutive segment indexes which are not used by any arena: the lowest ones
+        // left free by trim(), if any, so that trimming and enlarging a pool of compact items over and over does not
+        // run out of indexes.
+        size_t find_free_segment_indexes(size_t count) const
+        {
+            size_t run = 0;
+            for (size_t i = 0; i < m_segments.size(); i++) {
+                run = m_segments[i] ? 0 : run + 1;
+                if (run == count)
+                    return i + 1 - count;
+            }
+            return m_segments.size() - run; // the free indexes at the end get extended
+        }
+
+        virtual void recycle(boost_intrusive_pool_item* pitem_base) override { recycle_item(pitem_base); }
+        virtual void recycle_compact(boost_intrusive_pool_compact_item* pitem_base) override
+        {
+            recycle_item(pitem_base);
+        }
+
+        // items of the other kind never belong to this pool
+        void recycle_item(const void* pitem_base)
+        {
+            (void)pitem_base;
+            std::abort();
+        }
+
+        void recycle_item(item_base* pitem_base)
+        {
+            assert(pitem_base && is_in_use(pitem_base)); // Recycling an item that has been already recycled?
+            assert(pitem_base->_refcounted_item_get_pool() == this);
+
+            if (!is_owner_thread()) {
+                // the free list can be touched only by the thread owning this pool:
+                push_to_remote_free_list(pitem_base, pitem_base);
+                return;
+            }
+
+            if (m_trigger_self_destruction.load(std::memory_order_relaxed)) {
+                // this is an orphan pool (i.e. a pool without any boost_intrusive_pool<> associated to it anymore)
+                recycle_orphan(pitem_base, pitem_base);
+                return;
+            }
+
+            // sanity check:
+            if (!is_bounded()) {
+                assert(m_free_count > 0 || m_memory_exhausted);
+            }
+
+            recycle_into_free_list(pitem_base);
+
+#if BOOST_INTRUSIVE_POOL_DEBUG_CHECKS
+            pitem_base->check();
+#endif
+        }
+
+        // Recycles the items going from "first" to "last" into an orphan pool: once the pool is orphan, items can
+        // return to it from any thread, so this is serialized by a mutex. When no item is in use anymore,
+        // m_orphan_reference is released, triggering impl::~impl() which frees all arenas.
+        void recycle_orphan(item_base* first, item_base* last)
+        {
+            boost_intrusive_pool_iface_ptr last_reference; // released after unlocking the mutex
+            {
+                std::lock_guard<std::mutex> lock(m_orphan_mutex);
+                item_base* pcurr = first;
+                while (true) {
+                    item_base* pnext = (pcurr == last) ? nullptr : get_next(pcurr);
+                    recycle_into_free_list(pcurr);
+                    if (!pnext)
+                        break;
+                    pcurr = pnext;
+                }
+                if (m_inuse_count == 0)
+                    last_reference.swap(m_orphan_reference);
+            }
+        }
+
+        // Runs the recycle function on the given item and adds it at the beginning of the free list.
+        // Must be invoked only by the thread owning this pool.
+        void recycle_into_free_list(item_base* pitem_base)
+        {
+            m_recycle_policy(*boost_intrusive_pool_downcast<Item>(pitem_base));
+
+            push_free_item(pitem_base);
+            m_free_count++;
+
+            assert(m_inuse_count > 0);
+            m_inuse_count--;
+        }
+
+        // Adds the item at the beginning of the free list of its arena.
+        void push_free_item(item_base* pitem_base)
+        {
+            boost_intrusive_pool_arena<Item>* arena = arena_of(pitem_base);
+            set_next(pitem_base, arena->get_first_free_item());
+            arena->set_first_free_item(pitem_base);
+            arena->remove_inuse_items(1);
+            if (arena != m_alloc_arena)
+                m_occupancy_index.update(arena); // the arena chosen for allocations is not indexed
+        }
+
+        // Recycles a NULL-terminated chain of "count" items of this pool whose refcount already dropped to zero:
+        // the recycle policy runs on each of them right before it is added to the free list of its arena, in a tight
+        // loop updating the stats of the pool just once.
+        void recycle_chain(item_base* first, item_base* last, size_t count)
+        {
+            assert(first && last && count > 0);
+            assert(!m_trigger_self_destruction.load(std::memory_order_relaxed)); // invoked only through the pool
+
+            if (!is_owner_thread()) {
+                // the free list can be touched only by the thread owning this pool:
+                push_to_remote_free_list(first, last);
+                return;
+            }
+
+            // NOTE: the next item must be read before recycling, since RECYCLE_METHOD_DTOR constructs the header again
+            for (item_base* p = first; p;) {
+                item_base* pnext = get_next(p);
+                m_recycle_policy(*boost_intrusive_pool_downcast<Item>(p));
+                push_free_item(p);
+                p = pnext;
+            }
+            m_free_count += count;
+
+            assert(m_inuse_count >= count);
+            m_inuse_count -= count;
+        }
+
+        //------------------------------------------------------------------------------
+        // remote free list
+        //------------------------------------------------------------------------------
+
+        // NOTE: only the owner thread itself can change m_owner_thread (see set_owner_thread()), so the owner always
+        //       reads its own id here, while any other thread reads an id which is not its own, old or new
+        bool is_owner_thread() const
+        {
+            return m_owner_thread.load(std::memory_order_relaxed) == std::this_thread::get_id();
+        }
+        std::thread::id get_owner_thread() const { return m_owner_thread.load(std::memory_order_relaxed); }
+        void set_owner_thread(std::thread::id owner) { m_owner_thread.store(owner, std::memory_order_release); }
+
+        // Invoked when the last reference to an item (or to a chain of items, going from "first" to "last") is
+        // released by a thread which does not own this pool.
+        // The items are pushed with a single compare-and-swap into an inbox which is drained in bulk by the owner
+        // thread when its free list becomes empty.
+        void push_to_remote_free_list(item_base* first, item_base* last)
+        {
+            link_type head = m_remote_free_list.load(std::memory_order_relaxed);
+            do {
+                if (head == closed_link()) {
+                    // this is an orphan pool: the owner thread will not drain the inbox anymore
+                    recycle_orphan(first, last);
+                    return;
+                }
+                set_next_link(last, head);
+            } while (!m_remote_free_list.compare_exchange_weak(head, to_link(first), std::memory_order_release));
+
+            // NOTE: this pool must not be touched anymore: if it has become orphan meanwhile, the items just pushed
+            //       might have been the last ones in use and this pool might have been destroyed already
+        }
+
+        // Moves into the free list all items released by threads other than the owner of this pool.
+        // Must be invoked only by the thread owning this pool.
+        void drain_remote_free_list()
+        {
+            if (m_remote_free_list.load(std::memory_order_relaxed) == null_link())
+                return; // fast path: no atomic read-modify-write needed
+
+            item_base* pcurr = from_link(m_remote_free_list.exchange(null_link(), std::memory_order_acquire));
+            while (pcurr) {
+                item_base* pnext = get_next(pcurr);
+                recycle_into_free_list(pcurr);
+                pcurr = pnext;
+            }
+        }
+
+        //------------------------------------------------------------------------------
+        // links between items
+        // Free items are linked through their "next" pointer or, for compact items, through their "next" index:
+        // these functions hide the difference.
+        //------------------------------------------------------------------------------
+
+        typedef std::is_base_of<boost_intrusive_pool_compact_item, Item> is_compact;
+        typedef typename std::conditional<is_compact::value, uint32_t, boost_intrusive_pool_item*>::type link_type;
+
+        static boost_intrusive_pool_item* to_link(boost_intrusive_pool_item* p) { return p; }
+        static boost_intrusive_pool_item* from_link(boost_intrusive_pool_item* link) { return link; }
+        static boost_intrusive_pool_item* get_next_link(const boost_intrusive_pool_item* p)
+        {
+            return p->_refcounted_item_get_next();
+        }
+        static void set_next_link(boost_intrusive_pool_item* p, boost_intrusive_pool_item* link)
+        {
+            p->_refcounted_item_set_next(link);
+        }
+        static void set_in_use(boost_intrusive_pool_item* p) { p->_refcounted_item_set_next(nullptr); }
+        static bool is_in_use(const boost_intrusive_pool_item* p) { return p->_refcounted_item_get_next() == nullptr; }
+        static void relink_item(boost_intrusive_pool_item* p) { p->_refcounted_item_set_pooled(true); }
+
+        // the index of a compact item is the index of its segment times the number of items per segment,
+        // plus its position inside the segment
+        uint32_t to_link(boost_intrusive_pool_compact_item* p) const
+        {
+            if (!p)
+                return boost_intrusive_pool_compact_item::k_end_of_list;
+            const boost_intrusive_pool_segment* segment = boost_intrusive_pool_segment_of(p);
+            size_t position = ((const char*)boost_intrusive_pool_arena<Item>::slot_of(p) - (const char*)segment
+                                  - boost_intrusive_pool_arena<Item>::items_offset())
+                / sizeof(Item);
+            return segment->m_index * boost_intrusive_pool_arena<Item>::items_per_segment() + position;
+        }
+        boost_intrusive_pool_compact_item* from_link(uint32_t index) const
+        {
+            if (index == boost_intrusive_pool_compact_item::k_end_of_list)
+                return nullptr;
+            const size_t items_per_segment = boost_intrusive_pool_arena<Item>::items_per_segment();
+            assert(index / items_per_segment < m_segments.size());
+            Item* slot = reinterpret_cast<Item*>(m_segments[index / items_per_segment]
+                + boost_intrusive_pool_arena<Item>::items_offset() + (index % items_per_segment) * sizeof(Item));
+            return boost_intrusive_pool_arena<Item>::header_of(slot);
+        }
+        static uint32_t get_next_link(const boost_intrusive_pool_compact_item* p)
+        {
+            return p->_refcounted_item_get_next_index();
+        }
+        static void set_next_link(boost_intrusive_pool_compact_item* p, uint32_t index)
+        {
+            p->_refcounted_item_set_next_index(index);
+        }
+        static void set_in_use(boost_intrusive_pool_compact_item* p)
+        {
+            p->_refcounted_item_set_next_index(boost_intrusive_pool_compact_item::k_in_use);
+        }
+        static bool is_in_use(const boost_intrusive_pool_compact_item* p)
+        {
+            return p->_refcounted_item_get_next_index() == boost_intrusive_pool_compact_item::k_in_use;
+        }
+        static void relink_item(boost_intrusive_pool_compact_item* p) { set_in_use(p); }
+
+        link_type null_link() const { return to_link(static_cast<item_base*>(nullptr)); }
+        // the value of m_remote_free_list once the pool is orphan: it never refers to any item
+        // (items are aligned at least at pointer size, so 1 cannot be the address of an item)
+        static boost_intrusive_pool_item* closed_link(std::false_type /* compact */)
+        {
+            return reinterpret_cast<boost_intrusive_pool_item*>(uintptr_t(1));
+        }
+        static uint32_t closed_link(std::true_type /* compact */)
+        {
+            return boost_intrusive_pool_compact_item::k_in_use;
+        }
+        static link_type closed_link() { return closed_link(is_compact()); }
+        item_base* get_next(const item_base* p) const { return from_link(get_next_link(p)); }
+        void set_next(item_base* p, item_base* next) { set_next_link(p, to_link(next)); }
+
+        // free items are converted into items without static_cast<> when they are just raw storage
+        Item* item_of(item_base* p) const
+        {
+            if (has_raw_slots())
+                return boost_intrusive_pool_arena<Item>::slot_of(p);
+            return boost_intrusive_pool_downcast<Item>(p);
+        }
+
+        // the arena containing an item is found through the header of its segment
+        static boost_intrusive_pool_arena<Item>* arena_of(const item_base* p)
+        {
+            return static_cast<boost_intrusive_pool_arena<Item>*>(boost_intrusive_pool_segment_of(p)->m_arena);
+        }
+
+        //------------------------------------------------------------------------------
+        // other functions operating on items
+        //------------------------------------------------------------------------------
+
+        // THIS IS A SUPER DANGEROUS FUNCTION: IT JUST REMOVES ALL ARENAS OF THIS MEMORY POOL WITHOUT ANY
+        // CHECK WHETHER THERE ARE boost::intrusive_ptr<> OUT THERE STILL POINTING TO ITEMS INSIDE THOSE
+        // ARENAS. USE
+        void clear()
+        {
+            if (m_first_arena) {
+                size_t init_size = m_first_arena->get_stored_item_count();
+                boost_intrusive_pool_arena<Item>* pcurr = m_first_arena;
+                while (pcurr) {
+                    boost_intrusive_pool_arena<Item>* pnext = pcurr->get_next_arena();
+                    delete pcurr;
+                    pcurr = pnext;
+                }
+            } else {
+                // this memory pool has just been clear()ed... the last arena pointer should be null as well:
+                assert(m_last_arena == nullptr);
+            }
+
+            // status
+            m_alloc_arena = nullptr;
+            m_occupancy_index.clear();
+            m_first_arena = nullptr;
+            m_last_arena = nullptr;
+            m_segments.clear();
+            m_memory_exhausted = false;
+
+            // stats
+            m_free_count = 0;
+            m_inuse_count = 0;
+            m_total_count = 0;
+            m_enlarge_steps = 0;
+            m_huge_page_memory = 0;
+            m_locked_memory = 0;
+            std::fill(m_numa_capacity, m_numa_capacity + BOOST_INTRUSIVE_POOL_MAX_NUMA_NODES, 0);
+        }
+
+        void check()
+        {
+            if (m_first_arena) {
+                // this memory pool has been correctly initialized
+                assert(m_last_arena);
+                assert(m_total_count > 0);
+
+                // this condition should hold at any time:
+                assert(m_free_count + m_inuse_count == m_total_count);
+
+                // the counters and the free lists of the arenas must be consistent with the ones of the pool, and all
+                // arenas having free items must be indexed, except the one chosen for allocations:
+                size_t arena_inuse_count = 0, arena_total_count = 0;
+                for (const boost_intrusive_pool_arena<Item>* p = m_first_arena; p; p = p->get_next_arena()) {
+                    arena_inuse_count += p->get_inuse_count();
+                    arena_total_count += p->get_reserved_item_count();
+                    size_t arena_free_count = p->get_pending_item_count();
+                    for (const item_base* pitem = p->get_first_free_item(); pitem; pitem = get_next(pitem)) {
+                        assert(arena_of(pitem) == p);
+                        arena_free_count++;
+                    }
+                    assert(arena_free_count == p->get_available_item_count());
+                    assert(p == m_alloc_arena || m_occupancy_index.contains(p) == (arena_free_count > 0));
+                }
+                assert(arena_inuse_count == m_inuse_count && arena_total_count == m_total_count);
+                if (is_bounded()) {
+                    // when the memory pool is bounded it contains only 1 arena of a fixed size:
+                    assert(m_first_arena == m_last_arena);
+                } else {
+                    // infinite or max size memory pool: either we have a valid free element or the last malloc() must
+                    // have failed or the maximum size has been reached:
+                    assert(m_free_count > 0 || m_memory_exhausted);
+                }
+            } else {
+                // this memory pool has just been cleared with clear() apparently:
+                assert(!m_last_arena);
+                assert(!m_alloc_arena);
+                assert(m_free_count == 0);
+                assert(m_inuse_count == 0);
+                assert(m_total_count == 0);
+            }
+        }
+
+        //------------------------------------------------------------------------------
+        // getters
+        //------------------------------------------------------------------------------
+
+        // returns true if there are no elements in use.
+        // Note that if empty()==true, it does not mean that capacity()==0 as well!
+        bool empty() const { return m_free_count == m_total_count; }
+
+        bool is_bounded() const { return m_enlarge_step == 0; }
+
+        bool is_limited() const { return (m_enlarge_step == 0 || m_max_size != 0); }
+
+        bool can_be_enlarged() const { return m_enlarge_step > 0 && (m_max_size == 0 || m_total_count < m_max_size); }
+
+        bool is_memory_exhausted() const { return m_memory_exhausted; }
+
+        // returns the current (=maximum) capacity of the object pool
+        size_t capacity() const { return m_total_count; }
+
+        size_t max_size() const { return (m_enlarge_step != 0) ? m_max_size : m_total_count; }
+
+        // returns the number of free entries of the pool
+        size_t unused_count() const { return m_free_count; }
+
+        // returns the number of items currently malloc()ed from this pool
+        size_t inuse_count() const { return m_inuse_count; }
+
+        // returns the number of mallocs done so far
+        size_t enlarge_steps_done() const { return m_enlarge_steps; }
+
+        // returns the fraction of the items of the arenas having items in use which are free: zero when the items in
+        // use are packed densely, close to one when a few items in use keep many arenas from being released
+        double fragmentation() const
+        {
+            size_t nonidle_count = 0;
+            for (const boost_intrusive_pool_arena<Item>* p = m_first_arena; p; p = p->get_next_arena()) {
+                if (p->get_inuse_count() > 0)
+                    nonidle_count += p->get_reserved_item_count();
+            }
+            return (nonidle_count > 0) ? 1.0 - (double)m_inuse_count / (double)nonidle_count : 0.0;
+        }
+
+        size_t huge_page_memory() const { return m_huge_page_memory; }
+        size_t locked_memory() const { return m_locked_memory; }
+        size_t numa_node_capacity(int node) const
+        {
+            return (node >= 0 && node < BOOST_INTRUSIVE_POOL_MAX_NUMA_NODES) ? m_numa_capacity[node] : 0;
+        }
+
+    public:
+        // The recycle strategy & function
+        recycle_method_e m_recycle_method;
+        RecyclePolicy m_recycle_policy;
+
+        // How many new items to add each time the pool becomes full?
+        // If this is zero, then this is a bounded pool, which cannot grow beyond
+        // the initial size provided at construction time.
+        size_t m_enlarge_step;
+        // Maximum pool size.
+        // If this is zero, then it is ignored.
+        // If this is greater then zero, then no more items will be added to the pull if resulting size would exceed
+        // this value. If enlarge_step is zero, the max_size parameter become meaningless.
+        size_t m_max_size;
+        // How many items to add with each enlarge step, starting from m_enlarge_step
+        boost_intrusive_pool_growth_state m_growth;
+        // Where the memory of the arenas comes from
+        memory_backing_e m_memory_backing;
+        boost_intrusive_pool_memory_source* m_memory_source; // NULL to use the heap (or huge pages)
+
+        // Pointers to first and last arenas.
+        // First arena is changed only at
+        //  - construction time
+        //  - in clear()
+        //  - in reset(size_t)
+        // Pointer to last arena is instead updated on every enlarge step.
+        boost_intrusive_pool_arena<Item>* m_first_arena;
+        boost_intrusive_pool_arena<Item>* m_last_arena;
+
+        // The base address of all segments of all arenas, indexed by boost_intrusive_pool_segment::m_index:
+        // used only by memory pools of compact items, to find the item corresponding to an index.
+        std::vector<char*> m_segments;
+
+        // The thread which owns this pool: the one which created it, until it hands the pool over to another thread
+        // through set_owner_thread(). Only this thread can touch the free list.
+        std::atomic<std::thread::id> m_owner_thread;
+
+        // List of items released by threads other than the owner: the MPSC "remote free" inbox.
+        // Any thread can push into it with a compare-and-swap; only the owner thread drains it, detaching all items
+        // at once, so that the ABA problem does not apply here. Once the pool is orphan, the inbox is closed (see
+        // trigger_self_destruction()).
+        std::atomic<link_type> m_remote_free_list;
+
+        // Each arena keeps the list of its own free elements which have been recycled at least once, followed by the
+        // slots reserved by enlarge() and never used so far.
+        // Items are allocated out of m_alloc_arena until it has no free items left; then the fullest arena among the
+        // ones having free items, which are kept in m_occupancy_index, is chosen. This way the items in use are packed
+        // densely and the arenas holding few of them become idle over time.
+        // m_alloc_arena can be NULL only if there are no free items at all, which happens only whether:
+        // - an infinite memory pool has exhausted memory (malloc returned NULL);
+        // - a bounded memory pool has exhausted all its items
+        // - a maximum size memory pool has exhausted all its items and reached the limit
+        // In such cases m_memory_exhausted==true
+        boost_intrusive_pool_arena<Item>* m_alloc_arena;
+        boost_intrusive_pool_occupancy_index<Item> m_occupancy_index;
+        // This flag can be true if allocation by enlarge() failed or this is a fixed-size memory pool or this is a
+        // maximum size memory pool!
+        bool m_memory_exhausted;
+
+        // stats
+        // This should hold always:
+        //         m_free_count+m_inuse_count == m_total_count
+        // NOTE: items in the remote free list are still counted as in use, until the owner thread drains them;
+        //       m_free_count includes the slots which have never been used so far.
+        size_t m_free_count;
+        size_t m_inuse_count;
+        size_t m_total_count;
+        size_t m_enlarge_steps;
+        size_t m_huge_page_memory; // bytes of arena memory backed by huge pages
+        size_t m_locked_memory; // bytes of arena memory locked with mlock()
+        size_t m_numa_capacity[BOOST_INTRUSIVE_POOL_MAX_NUMA_NODES]; // items whose memory is bound to each NUMA node
+
+        // This flag is read only by the owner thread: other threads find the remote free list closed instead
+        std::atomic<bool> m_trigger_self_destruction;
+
+        // Used only by orphan pools: see recycle_orphan()
+        std::mutex m_orphan_mutex;
+        boost_intrusive_pool_iface_ptr m_orphan_reference;
+    };
+
+private:
+    // The pool impl
+    boost::intrusive_ptr<impl> m_pool;
+};
+
+//------------------------------------------------------------------------------
+// concurrent_boost_intrusive_pool
+// A thread-safe variant of the boost_intrusive_pool: items can be allocated from
+// and returned to the pool by any thread, without any lock in the fast path.
+//------------------------------------------------------------------------------
+
+template <class Item, class RecyclePolicy = boost_intrusive_pool_runtime_recycle<Item>>
+class concurrent_boost_intrusive_pool {
+public:
+    static_assert(std::is_base_of<boost_intrusive_pool_item, Item>::value,
+        "items of a memory pool must derive from boost_intrusive_pool_item");
+    static_assert(std::is_default_constructible<Item>::value
+            || boost_intrusive_pool_is_runtime_recycle<RecyclePolicy, Item>::value,
+        "items without a default ctor require a memory pool using RECYCLE_METHOD_DTOR");
+
+    // The type of pointers provided by this memory pool implementation
+    using item_ptr = boost::intrusive_ptr<Item>;
+
+    // The allocate function type: see boost_intrusive_pool::allocate_function
+    using allocate_function = std::function<void(Item&)>;
+
+    // The recycle function type
+    // NOTE: the recycle function is invoked by the thread releasing the last reference to the item.
+    using recycle_function = std::function<void(Item&)>;
+
+    // The growth policy type: see boost_intrusive_pool_growth_info
+    using growth_function = boost_intrusive_pool_growth_function;
+
+public:
+    // Default constructor
+    // Leaves this memory pool uninitialized. It's mandatory to invoke init() after this one.
+    concurrent_boost_intrusive_pool() { m_pool = nullptr; }
+
+    // Constructs a memory pool quite small which increases its size by rather small steps.
+    // See boost_intrusive_pool for the meaning of the parameters.
+    concurrent_boost_intrusive_pool(size_t init_size, size_t enlarge_size = BOOST_INTRUSIVE_POOL_INCREASE_STEP,
+        size_t max_size = BOOST_INTRUSIVE_POOL_NO_MAX_SIZE, recycle_method_e recycle_method = RECYCLE_METHOD_NONE,
+        recycle_function recycle_fn = nullptr, memory_backing_e memory_backing = MEMORY_BACKING_DEFAULT,
+        boost_intrusive_pool_memory_source* memory_source = nullptr)
+    {
+        // NOTE: return value is ignored... if the software is out of memory... we can't do much within a ctor
+        init(init_size, enlarge_size, max_size, recycle_method, recycle_fn, memory_backing, memory_source);
+    }
+    virtual ~concurrent_boost_intrusive_pool()
+    {
+        if (m_pool)
+            m_pool->trigger_self_destruction();
+    }
+
+    // Copy constructor
+    concurrent_boost_intrusive_pool(const concurrent_boost_intrusive_pool& other) = delete;
+
+    // Move constructor
+    concurrent_boost_intrusive_pool(concurrent_boost_intrusive_pool&& other) = delete;
+
+    // Copy assignment
+    concurrent_boost_intrusive_pool& operator=(const concurrent_boost_intrusive_pool& other) = delete;
+
+    // Move assignment
+    concurrent_boost_intrusive_pool& operator=(concurrent_boost_intrusive_pool&& other) = delete;
+
+    //------------------------------------------------------------------------------
+    // configuration/initialization methods
+    // These are NOT thread-safe: they must be invoked before sharing the pool with other threads.
+    //------------------------------------------------------------------------------
+
+    bool init(size_t init_size = BOOST_INTRUSIVE_POOL_DEFAULT_POOL_SIZE,
+        size_t enlarge_size = BOOST_INTRUSIVE_POOL_INCREASE_STEP, size_t max_size = BOOST_INTRUSIVE_POOL_NO_MAX_SIZE,
+        recycle_method_e recycle_method = RECYCLE_METHOD_NONE, recycle_function recycle_fn = nullptr,
+        memory_backing_e memory_backing = MEMORY_BACKING_DEFAULT,
+        boost_intrusive_pool_memory_source* memory_source = nullptr)
+    {
+        assert(m_pool == nullptr); // cannot initialize twice the memory pool
+        assert(init_size > 0);
+        assert((max_size == BOOST_INTRUSIVE_POOL_NO_MAX_SIZE) || (max_size >= init_size && enlarge_size > 0));
+
+        m_pool = boost::intrusive_ptr<impl>(
+            new impl(enlarge_size, max_size, recycle_method, recycle_fn, memory_backing, memory_source));
+
+        // do initial malloc
+        std::lock_guard<std::mutex> lock(m_pool->m_enlarge_mutex);
+        return m_pool->enlarge(init_size);
+    }
+
+    void set_recycle_method(recycle_method_e method, recycle_function recycle_fn = nullptr)
+    {
+        assert(m_pool); // pool must be initialized
+        m_pool->set_recycle_method(method, recycle_fn);
+    }
+
+    // Selects how many items each enlarge step adds to the pool: see boost_intrusive_pool::set_growth_policy()
+    template <typename GrowthPolicy> void set_growth_policy(GrowthPolicy growth_fn)
+    {
+        assert(m_pool); // pool must be initialized
+        std::lock_guard<std::mutex> lock(m_pool->m_enlarge_mutex);
+        m_pool->m_growth.set_policy(growth_fn, boost_intrusive_pool_growth_uses_elapsed_time<GrowthPolicy>::value);
+    }
+
+    // Enables a per-thread cache of free items in front of the shared free list: each thread keeps up to
+    // magazine_size free items in a private LIFO (a "magazine"), which is refilled from and spilled to the shared free
+    // list in batches of magazine_size/2 items. In this way most allocations and recycles never touch any shared
+    // cache line. A magazine_size of zero disables the per-thread cache (default).
+    // NOTE: items sitting in a magazine are counted by inuse_count() and not by unused_count().
+    void set_magazine_size(size_t magazine_size)
+    {
+        assert(m_pool); // pool must be initialized
+        m_pool->m_magazine_size = magazine_size;
+    }
+
+    // Returns to the shared free list all items kept in the magazine of the calling thread.
+    // Magazines are automatically flushed when their thread exits; this is useful e.g. when a thread stops using
+    // the pool for a long time.
+    void flush_thread_cache()
+    {
+        if (m_pool)
+            m_pool->flush_thread_cache();
+    }
+
+    //------------------------------------------------------------------------------
+    // allocate method variants
+    // These are all thread-safe.
+    //------------------------------------------------------------------------------
+
+    // Returns the first available free item.
+    item_ptr allocate()
+    {
+        assert(m_pool); // pool must be initialized
+        Item* recycled_item = m_pool->allocate_safe_get_recycled_item();
+        if (!recycled_item)
+            return nullptr;
+        if (m_pool->has_raw_slots())
+            boost_intrusive_pool_construct(recycled_item);
+
+        item_ptr ret_ptr(recycled_item);
+#if BOOST_INTRUSIVE_POOL_DEBUG_CHECKS
+        ret_ptr->check();
+#endif
+        return ret_ptr;
+    }
+
+    // Returns first available free item or, if necessary and the memory pool is unbounded and has not reached the
+    // maximum size, allocates a new item. Uses C++11 perfect forwarding to the init() function of the memory pooled
+    // item.
+    template <typename... Args> item_ptr allocate_through_init(Args&&... args)
+    {
+        assert(m_pool); // pool must be initialized
+        Item* recycled_item = m_pool->allocate_safe_get_recycled_item();
+        if (!recycled_item)
+            return nullptr;
+
+        boost_intrusive_pool_init(recycled_item, m_pool->has_raw_slots(), std::forward<Args>(args)...);
+
+        item_ptr ret_ptr(recycled_item);
+#if BOOST_INTRUSIVE_POOL_DEBUG_CHECKS
+        ret_ptr->check();
+#endif
+        return ret_ptr;
+    }
+
+    // Returns first available free item or, if necessary and the memory pool is unbounded,
+    // allocates a new item. The given callable is invoked directly (and can be inlined) on the item.
+    template <typename Function> item_ptr allocate_through_function(Function&& fn)
+    {
+        assert(m_pool); // pool must be initialized
+        Item* recycled_item = m_pool->allocate_safe_get_recycled_item();
+        if (!recycled_item)
+            return nullptr;
+
+        if (m_pool->has_raw_slots())
+            boost_intrusive_pool_construct(recycled_item);
+        uint32_t header = boost_intrusive_pool_save_header(recycled_item);
+        fn(*recycled_item);
+
+        // the function may run the ctor of the item again, which resets its header: see
+        // boost_intrusive_pool::allocate_through_function()
+        boost_intrusive_pool_restore_header(recycled_item, header);
+
+        item_ptr ret_ptr(recycled_item);
+#if BOOST_INTRUSIVE_POOL_DEBUG_CHECKS
+        ret_ptr->check();
+#endif
+        return ret_ptr;
+    }
+
+    //------------------------------------------------------------------------------
+    // other functions operating on items
+    //------------------------------------------------------------------------------
+
+    // Verifies the integrity of the memory pool.
+    // NOTE: results are meaningful only if no other thread is using the memory pool at the same time.
+    void check()
+    {
+        if (!m_pool)
+            return; // nothing to do
+        m_pool->check();
+    }
+
+    //------------------------------------------------------------------------------
+    // getters
+    // NOTE: when other threads are using the memory pool, these only provide a snapshot of its status.
+    //------------------------------------------------------------------------------
+
+    // returns true if there are no elements in use.
+    // Note that if empty()==true, it does not mean that capacity()==0 as well!
+    bool empty() const { return m_pool ? m_pool->empty() : true; }
+
+    bool is_bounded() const { return m_pool ? m_pool->is_bounded() : false; }
+
+    bool is_limited() const { return m_pool ? m_pool->is_limited() : false; }
+
+    bool is_memory_exhausted() const { return m_pool ? m_pool->is_memory_exhausted() : false; }
+
+    // returns the current (=maximum) capacity of the object pool
+    size_t capacity() const { return m_pool ? m_pool->capacity() : 0; }
+
+    size_t max_size() const { return m_pool ? m_pool->max_size() : 0; }
+
+    // returns the number of free entries of the pool
+    size_t unused_count() const { return m_pool ? m_pool->unused_count() : 0; }
+
+    // returns the number of items currently malloc()ed from this pool
+    size_t inuse_count() const { return m_pool ? m_pool->inuse_count() : 0; }
+
+    // returns the number of mallocs done so far
+    size_t enlarge_steps_done() const { return m_pool ? m_pool->enlarge_steps_done() : 0; }
+
+    // returns the number of bytes of arena memory obtained from huge pages: zero unless the pool has been created with
+    // MEMORY_BACKING_HUGE_PAGES and huge pages are available
+    size_t huge_page_memory() const { return m_pool ? m_pool->huge_page_memory() : 0; }
+
+    // returns the number of bytes of arena memory locked in RAM: zero unless the pool has been created with
+    // MEMORY_BACKING_LOCKED and the RLIMIT_MEMLOCK limit allows locking its arenas
+    size_t locked_memory() const { return m_pool ? m_pool->locked_memory() : 0; }
+
+    // returns the number of items whose memory is bound to the given NUMA node: zero unless the pool has been created
+    // with MEMORY_BACKING_NUMA_LOCAL or with a memory source binding its memory to that node (see
+    // boost_intrusive_pool_numa_memory_source) and the machine supports NUMA
+    size_t numa_node_capacity(int node) const { return m_pool ? m_pool->numa_node_capacity(node) : 0; }
+
+private:
+    /// The actual pool implementation.
+    /// Free items are kept inside a boost_intrusive_pool_lockfree_stack; the list of arenas is instead
+    /// protected by a mutex which is taken only when the pool needs to be enlarged.
+    class impl : public boost_intrusive_pool_iface {
+    public:
+        impl(size_t enlarge_size, size_t max_size, recycle_method_e method, recycle_function recycle,
+            memory_backing_e memory_backing, boost_intrusive_pool_memory_source* memory_source)
+        {
+            // configurations
+            // items without a default ctor can be constructed only when they get allocated:
+            assert(std::is_default_constructible<Item>::value || method == RECYCLE_METHOD_DTOR);
+            m_recycle_method = std::is_default_constructible<Item>::value ? method : RECYCLE_METHOD_DTOR;
+            boost_intrusive_pool_configure_recycle(m_recycle_policy, m_recycle_method, recycle);
+            m_enlarge_step = enlarge_size;
+            m_max_size = max_size;
+            m_memory_backing = memory_backing;
+            m_memory_source = memory_source;
+            m_magazine_size = 0;
+
+            // status
+            m_first_arena = nullptr;
+            m_last_arena = nullptr;
+            m_memory_exhausted.store(false);
+            m_trigger_self_destruction.store(false);
+
+            // stats
+            m_inuse_count.store(0);
+            m_total_count.store(0);
+            m_num_enlarge_steps.store(0);
+            m_huge_page_memory.store(0);
+            m_locked_memory.store(0);
+            for (std::atomic<size_t>& capacity : m_numa_capacity)
+                capacity.store(0);
+        }
+
+        ~impl()
+        {
+            // if this dtor is called, it means that all memory pooled items have been destroyed:
+            // m_orphan_reference is held on their behalf, so if one of them was alive, this dtor would not be called!
+            boost_intrusive_pool_arena<Item>* pcurr = m_first_arena;
+            while (pcurr) {
+                boost_intrusive_pool_arena<Item>* pnext = pcurr->get_next_arena();
+                delete pcurr;
+                pcurr = pnext;
+            }
+        }
+
+        void set_recycle_method(recycle_method_e method, recycle_function recycle = nullptr)
+        {
+            // the arenas contain either constructed items or raw storage, depending on RECYCLE_METHOD_DTOR:
+            assert((method == RECYCLE_METHOD_DTOR) == has_raw_slots());
+            m_recycle_method = method;
+            boost_intrusive_pool_configure_recycle(m_recycle_policy, method, recycle);
+        }
+
+        // returns true if free items are just raw storage where items get constructed when they are allocated
+        bool has_raw_slots() const
+        {
+            return boost_intrusive_pool_is_runtime_recycle<RecyclePolicy, Item>::value
+                && m_recycle_method == RECYCLE_METHOD_DTOR;
+        }
+
+        // free items are converted into items without static_cast<> when they are just raw storage
+        Item* item_of(boost_intrusive_pool_item* p) const
+        {
+            if (has_raw_slots())
+                return boost_intrusive_pool_arena<Item>::slot_of(p);
+            return boost_intrusive_pool_downcast<Item>(p);
+        }
+
+        void trigger_self_destruction()
+        {
+            // items do not hold a reference to this pool: from now on a single reference is held on behalf of all
+            // items still in use, and released by the thread recycling the last one (see push_to_free_list())
+            // The items in the magazine of the calling thread are counted as in use: return them first, otherwise
+            // this pool would stay alive, and keep the magazine, until this thread exits.
+            boost_intrusive_pool_magazine* magazine = get_thread_magazine(false);
+            if (magazine) {
+                spill_magazine(*magazine, 0);
+                magazine->m_owner = nullptr;
+            }
+            m_orphan_reference = this;
+            m_trigger_self_destruction.store(true, std::memory_order_relaxed);
+            if (m_inuse_count.fetch_or(k_orphan_flag, std::memory_order_acq_rel) == 0)
+                release_orphan_reference();
+        }
+
+        void release_orphan_reference()
+        {
+            boost_intrusive_pool_iface_ptr last_reference;
+            last_reference.swap(m_orphan_reference); // this is likely to trigger impl::~impl()
+        }
+
+        // NOTE: m_enlarge_mutex must be locked by the caller
+        size_t get_effective_enlarge_step() const
+        {
+            if (m_enlarge_step == 0)
+                return 0;
+            size_t total_count = m_total_count.load(std::memory_order_relaxed);
+            size_t enlarge_step = m_growth.get_next_step(
+                m_enlarge_step, total_count, m_num_enlarge_steps.load(std::memory_order_relaxed));
+            if (m_max_size > 0 && total_count + enlarge_step > m_max_size)
+                enlarge_step = m_max_size - total_count; // enlarge_step can be zero if we reach the max_size
+            return enlarge_step;
+        }
+
+        Item* allocate_safe_get_recycled_item()
+        {
+            boost_intrusive_pool_item* pitem;
+            boost_intrusive_pool_magazine* magazine = get_thread_magazine(true);
+            if (magazine) {
+                if (magazine->m_count == 0 && !refill_magazine(*magazine))
+                    return nullptr; // allocation by enlarge() failed or this is a fixed-size memory pool!
+                pitem = magazine->pop();
+            } else {
+                size_t count;
+                pitem = pop_from_free_list(1, count);
+                if (pitem == nullptr)
+                    return nullptr; // allocation by enlarge() failed or this is a fixed-size memory pool!
+            }
+
+            assert(pitem->_refcounted_item_get_pool() == this);
+            assert(pitem->_refcounted_item_get_next() == nullptr); // pop() unlinks the item
+            return item_of(pitem);
+        }
+
+        // Detaches up to max_count items from the shared free list, enlarging the pool if necessary.
+        boost_intrusive_pool_item* pop_from_free_list(size_t max_count, size_t& count)
+        {
+            boost_intrusive_pool_item* pitem = m_free_list.pop_chain(max_count, count);
+            while (pitem == nullptr) {
+                // slow path: the free list is empty
+                if (!enlarge_if_still_empty())
+                    return nullptr;
+                pitem = m_free_list.pop_chain(max_count, count);
+            }
+
+            m_inuse_count.fetch_add(count, std::memory_order_relaxed);
+            return pitem;
+        }
+
+        // Gives back to the shared free list a NULL-terminated chain of items.
+        void push_to_free_list(boost_intrusive_pool_item* first, boost_intrusive_pool_item* last, size_t count)
+        {
+#if BOOST_INTRUSIVE_POOL_DEBUG_CHECKS
+            assert(inuse_count() >= count);
+#endif
+            m_free_list.push_chain(first, last);
+
+            // test for self-destruction:
+            // is this an orphan pool (i.e. a pool without any concurrent_boost_intrusive_pool<> associated to it
+            // anymore) and are these the last items in use? In such case release the last reference to this pool,
+            // and impl::~impl() will get called, freeing all arenas!
+            // NOTE: otherwise this pool must not be touched after updating the counter: if it has become orphan
+            //       meanwhile, another thread might recycle the last items and destroy it.
+            if (m_inuse_count.fetch_sub(count, std::memory_order_acq_rel) == (k_orphan_flag | count))
+                release_orphan_reference();
+        }
+
+        //------------------------------------------------------------------------------
+        // per-thread magazines
+        //------------------------------------------------------------------------------
+
+        boost_intrusive_pool_magazine* get_thread_magazine(bool create)
+        {
+            if (m_magazine_size == 0)
+                return nullptr;
+            return boost_intrusive_pool_thread_cache::get_magazine(this, &impl::flush_magazine, create);
+        }
+
+        size_t get_magazine_batch_size() const { return (m_magazine_size > 1) ? m_magazine_size / 2 : 1; }
+
+        bool refill_magazine(boost_intrusive_pool_magazine& magazine)
+        {
+            assert(magazine.m_count == 0);
+            magazine.m_first = pop_from_free_list(get_magazine_batch_size(), magazine.m_count);
+            return magazine.m_first != nullptr;
+        }
+
+        // Keeps in the magazine only the most recently recycled items (which are likely to be hot in cache)
+        // and gives back all the others to the shared free list.
+        void spill_magazine(boost_intrusive_pool_magazine& magazine, size_t num_items_to_keep)
+        {
+            boost_intrusive_pool_item* first;
+            if (num_items_to_keep == 0) {
+                first = magazine.m_first;
+                magazine.m_first = nullptr;
+            } else {
+                boost_intrusive_pool_item* split = magazine.m_first;
+                for (size_t i = 1; i < num_items_to_keep; i++)
+                    split = split->_refcounted_item_get_next();
+                first = split->_refcounted_item_get_next();
+                split->_refcounted_item_set_next(nullptr);
+            }
+
+            size_t count = magazine.m_count - num_items_to_keep;
+            magazine.m_count = num_items_to_keep;
+            if (count == 0)
+                return;
+
+            boost_intrusive_pool_item* last = first;
+            while (last->_refcounted_item_get_next())
+                last = last->_refcounted_item_get_next();
+            push_to_free_list(first, last, count);
+        }
+
+        // Invoked when a thread exits with a non-empty magazine
+        static void flush_magazine(boost_intrusive_pool_magazine& magazine)
+        {
+            // NOTE: the items of the magazine are counted as in use, so the pool is still alive
+            impl* pool = const_cast<impl*>(static_cast<const impl*>(magazine.m_owner));
+            pool->spill_magazine(magazine, 0);
+        }
+
+        void flush_thread_cache()
+        {
+            boost_intrusive_pool_magazine* magazine = get_thread_magazine(false);
+            if (magazine)
+                spill_magazine(*magazine, 0);
+        }
+
+        bool enlarge_if_still_empty()
+        {
+            std::lock_guard<std::mutex> lock(m_enlarge_mutex);
+            if (!m_free_list.empty())
+                return true; // some other thread has recycled items or enlarged the pool meanwhile
+
+            size_t enlarge_step = get_effective_enlarge_step();
+            if (enlarge_step == 0 || !enlarge(enlarge_step)) {
+                m_memory_exhausted.store(true, std::memory_order_relaxed);
+                return false;
+            }
+            return true;
+        }
+
+        // NOTE: m_enlarge_mutex must be locked by the caller
+        bool enlarge(size_t arena_size)
+        {
+            // If the last arena has no room for the new items, create a new one.
+            if (!m_last_arena || m_last_arena->get_free_slot_count() < arena_size) {
+                // NOTE: segment indexes are used only by memory pools of compact items
+                boost_intrusive_pool_arena<Item>* new_arena
+                    = boost_intrusive_pool_arena<Item>::create(arena_size, this, 0, m_memory_backing, m_memory_source);
+                if (!new_arena)
+                    return false; // malloc failed... memory finished... very likely this is a game over
+                if (!boost_intrusive_pool_lockfree_stack::can_hold(
+                        new_arena->get_segment(0), new_arena->get_memory_size())) {
+                    delete new_arena; // its items could not be linked into the free lists
+                    return false;
+                }
+                if (new_arena->is_on_huge_pages())
+                    m_huge_page_memory.fetch_add(new_arena->get_memory_size(), std::memory_order_relaxed);
+                if (new_arena->is_locked())
+                    m_locked_memory.fetch_add(new_arena->get_memory_size(), std::memory_order_relaxed);
+
+                // Link the new arena to the last one.
+                if (m_last_arena)
+                    m_last_arena->set_next_arena(new_arena);
+                else
+                    m_first_arena = new_arena; // apparently we are initializing the memory pool for the very first time
+                m_last_arena = new_arena;
+            }
+            boost_intrusive_pool_item* new_items = m_last_arena->add_items(arena_size, has_raw_slots());
+            if (m_last_arena->get_numa_node() >= 0)
+                m_numa_capacity[m_last_arena->get_numa_node()].fetch_add(arena_size, std::memory_order_relaxed);
+
+            m_total_count.fetch_add(arena_size, std::memory_order_relaxed);
+            m_num_enlarge_steps.fetch_add(1, std::memory_order_relaxed);
+            m_growth.enlarged(arena_size);
+
+            // publish all the new items at once
+            m_free_list.push_chain(new_items, m_last_arena->get_last_header());
+            return true;
+        }
+
+        virtual void recycle(boost_intrusive_pool_item* pitem_base) override
+        {
+            assert(pitem_base
+                && pitem_base->_refcounted_item_get_next()
+                    == nullptr); // Recycling an item that has been already recycled?
+            assert(pitem_base->_refcounted_item_get_pool() == this);
+
+            m_recycle_policy(*boost_intrusive_pool_downcast<Item>(pitem_base));
+
+            // Add the item at the beginning of the magazine of this thread or of the shared free list.
+            // Orphan pools do not use magazines anymore: items are returned to the shared free list so that
+            // the last one can destroy the pool.
+            boost_intrusive_pool_magazine* magazine = get_thread_magazine(true);
+            if (magazine && !m_trigger_self_destruction.load(std::memory_order_relaxed)) {
+                magazine->push(pitem_base);
+                if (magazine->m_count > m_magazine_size)
+                    spill_magazine(*magazine, m_magazine_size - get_magazine_batch_size());
+            } else {
+                push_to_free_list(pitem_base, pitem_base, 1);
+            }
+        }
+
+        void check()
+        {
+            size_t total_count = m_total_count.load();
+            if (m_first_arena) {
+                // this memory pool has been correctly initialized
+                assert(m_last_arena);
+                assert(total_count > 0);
+
+                // this condition holds as long as no other thread is using the pool:
+                assert(m_free_list.unsafe_size() + inuse_count() == total_count);
+            } else {
+                assert(!m_last_arena);
+                assert(inuse_count() == 0);
+                assert(total_count == 0);
+            }
+        }
+
+        //------------------------------------------------------------------------------
+        // getters
+        //------------------------------------------------------------------------------
+
+        bool empty() const { return inuse_count() == 0; }
+
+        bool is_bounded() const { return m_enlarge_step == 0; }
+
+        bool is_limited() const { return (m_enlarge_step == 0 || m_max_size != 0); }
+
+        bool is_memory_exhausted() const { return m_memory_exhausted.load(std::memory_order_relaxed); }
+
+        size_t capacity() const { return m_total_count.load(std::memory_order_relaxed); }
+
+        size_t max_size() const { return (m_enlarge_step != 0) ? m_max_size : capacity(); }
+
+        size_t unused_count() const
+        {
+            size_t total_count = m_total_count.load(std::memory_order_relaxed);
+            size_t inuse = inuse_count();
+            return (inuse < total_count) ? total_count - inuse : 0;
+        }
+
+        size_t inuse_count() const { return m_inuse_count.load(std::memory_order_relaxed) & ~k_orphan_flag; }
+
+        size_t enlarge_steps_done() const { return m_num_enlarge_steps.load(std::memory_order_relaxed); }
+
+        size_t huge_page_memory() const { return m_huge_page_memory.load(std::memory_order_relaxed); }
+        size_t locked_memory() const { return m_locked_memory.load(std::memory_order_relaxed); }
+        size_t numa_node_capacity(int node) const
+        {
+            if (node < 0 || node >= BOOST_INTRUSIVE_POOL_MAX_NUMA_NODES)
+                return 0;
+            return m_numa_capacity[node].load(std::memory_order_relaxed);
+        }
+
+    public:
+        // The recycle strategy & function
+        recycle_method_e m_recycle_method;
+        RecyclePolicy m_recycle_policy;
+
+        // See boost_intrusive_pool::impl for the meaning of these configurations
+        size_t m_enlarge_step;
+        size_t m_max_size;
+        boost_intrusive_pool_growth_state m_growth; // protected by m_enlarge_mutex
+        memory_backing_e m_memory_backing;
+        boost_intrusive_pool_memory_source* m_memory_source;
+
+        // Maximum number of free items in each per-thread magazine; zero if magazines are disabled.
+        size_t m_magazine_size;
+
+        // Arenas list: protected by m_enlarge_mutex
+        std::mutex m_enlarge_mutex;
+        boost_intrusive_pool_arena<Item>* m_first_arena;
+        boost_intrusive_pool_arena<Item>* m_last_arena;
+
+        // List of free elements: lock-free.
+        boost_intrusive_pool_lockfree_stack m_free_list;
+
+        std::atomic<bool> m_memory_exhausted;
+        std::atomic<bool> m_trigger_self_destruction;
+
+        // Held on behalf of all items in use once this pool is orphan
+        boost_intrusive_pool_iface_ptr m_orphan_reference;
+
+        // stats
+        // NOTE: the number of free items is computed as m_total_count-m_inuse_count since
+        //       a separate counter would be yet another contended cache line.
+        //       m_inuse_count counts all items outside the shared free list, including those in magazines;
+        //       its highest bit is set once this pool is orphan.
+        static constexpr size_t k_orphan_flag = ~(~(size_t)0 >> 1);
+        std::atomic<size_t> m_inuse_count;
+        std::atomic<size_t> m_total_count;
+        std::atomic<size_t> m_num_enlarge_steps;
+        std::atomic<size_t> m_huge_page_memory; // bytes of arena memory backed by huge pages
+        std::atomic<size_t> m_locked_memory; // bytes of arena memory locked with mlock()
+        std::atomic<size_t> m_numa_capacity[BOOST_INTRUSIVE_POOL_MAX_NUMA_NODES]; // items bound to each NUMA node
+    };
 
-    // Storage of this arena.
-    // std::unique_ptr<Item[]> m_storage;
-    size_t m_storage_size;
-    Item* m_storage;
+private:
+    // The pool impl
+    boost::intrusive_ptr<impl> m_pool;
 };
 
 //------------------------------------------------------------------------------
-// boost_intrusive_pool
-// The actual memory pool implementation.
+// boost_intrusive_pool_get_current_cpu
+// Internal helper function for a sharded_boost_intrusive_pool.
+//------------------------------------------------------------------------------
+
+// Returns the index of the CPU the calling thread is running on.
+// The result is just a hint: the thread may be migrated to another CPU right after this call.
+inline unsigned int boost_intrusive_pool_get_current_cpu()
+{
+#if BOOST_INTRUSIVE_POOL_HAVE_RSEQ
+    if (__rseq_size > 0) {
+        // the rseq area of this thread has been registered by glibc: a single load is enough
+        const volatile struct rseq* rs
+            = reinterpret_cast<const volatile struct rseq*>((char*)__builtin_thread_pointer() + __rseq_offset);
+        return rs->cpu_id;
+    }
+#endif
+#ifdef __linux__
+    int cpu = sched_getcpu();
+    if (cpu >= 0)
+        return (unsigned int)cpu;
+#endif
+    // the CPU cannot be found out: at least spread different threads over different shards
+    return (unsigned int)std::hash<std::thread::id>()(std::this_thread::get_id());
+}
+
+//------------------------------------------------------------------------------
+// sharded_boost_intrusive_pool
+// A thread-safe variant of the boost_intrusive_pool which keeps a separate free
+// list (a "shard") for each CPU, so that threads running on different CPUs do not
+// contend on the same cache lines.
 //------------------------------------------------------------------------------
 
-template <class Item> class boost_intrusive_pool {
+template <class Item, class RecyclePolicy = boost_intrusive_pool_runtime_recycle<Item>>
+class sharded_boost_intrusive_pool {
 public:
-    // using dummy = typename std::enable_if<std::is_base_of<boost_intrusive_pool_item, Item>::value>::type;
+    static_assert(std::is_base_of<boost_intrusive_pool_item, Item>::value,
+        "items of a memory pool must derive from boost_intrusive_pool_item");
+    static_assert(std::is_default_constructible<Item>::value
+            || boost_intrusive_pool_is_runtime_recycle<RecyclePolicy, Item>::value,
+        "items without a default ctor require a memory pool using RECYCLE_METHOD_DTOR");
 
     // The type of pointers provided by this memory pool implementation
     using item_ptr = boost::intrusive_ptr<Item>;
 
-    // The allocate function type
+    // The allocate function type: see boost_intrusive_pool::allocate_function
     using allocate_function = std::function<void(Item&)>;
 
     // The recycle function type
-    // If specified the recycle function will be called every time a resource gets recycled into the pool. This allows
-    // temporary resources, e.g., file handles to be closed when an object is longer used.
+    // NOTE: the recycle function is invoked by the thread releasing the last reference to the item.
     using recycle_function = std::function<void(Item&)>;
 
+    // The growth policy type: see boost_intrusive_pool_growth_info
+    using growth_function = boost_intrusive_pool_growth_function;
+
 public:
     // Default constructor
     // Leaves this memory pool uninitialized. It's mandatory to invoke init() after this one.
-    boost_intrusive_pool() { m_pool = nullptr; }
+    sharded_boost_intrusive_pool() { m_pool = nullptr; }
 
     // Constructs a memory pool quite small which increases its size by rather small steps.
-    // Tuning of these steps is critical for performances.
-    // The ctor also allows you to specify which function should be run on items returning to the pool.
-    boost_intrusive_pool(size_t init_size, size_t enlarge_size = BOOST_INTRUSIVE_POOL_INCREASE_STEP,
+    // See boost_intrusive_pool for the meaning of the parameters; the initial items are spread evenly over all
+    // shards while each enlarge step of "enlarge_size" items goes to the shard which ran out of items.
+    // A "num_shards" of zero creates one shard for each CPU of the system.
+    sharded_boost_intrusive_pool(size_t init_size, size_t enlarge_size = BOOST_INTRUSIVE_POOL_INCREASE_STEP,
         size_t max_size = BOOST_INTRUSIVE_POOL_NO_MAX_SIZE, recycle_method_e recycle_method = RECYCLE_METHOD_NONE,
-        recycle_function recycle_fn = nullptr)
+        recycle_function recycle_fn = nullptr, size_t num_shards = 0,
+        memory_backing_e memory_backing = MEMORY_BACKING_DEFAULT,
+        boost_intrusive_pool_memory_source* memory_source = nullptr)
     {
         // NOTE: return value is ignored... if the software is out of memory... we can't do much within a ctor
-        init(init_size, enlarge_size, max_size, recycle_method, recycle_fn);
+        init(init_size, enlarge_size, max_size, recycle_method, recycle_fn, num_shards, memory_backing, memory_source);
     }
-    virtual ~boost_intrusive_pool()
+    virtual ~sharded_boost_intrusive_pool()
     {
         if (m_pool)
             m_pool->trigger_self_destruction();
     }
 
     // Copy constructor
-    boost_intrusive_pool(const boost_intrusive_pool& other) = delete;
+    sharded_boost_intrusive_pool(const sharded_boost_intrusive_pool& other) = delete;
 
     // Move constructor
-    boost_intrusive_pool(boost_intrusive_pool&& other) = delete;
+    sharded_boost_intrusive_pool(sharded_boost_intrusive_pool&& other) = delete;
 
     // Copy assignment
-    boost_intrusive_pool& operator=(const boost_intrusive_pool& other) = delete;
+    sharded_boost_intrusive_pool& operator=(const sharded_boost_intrusive_pool& other) = delete;
 
     // Move assignment
-    boost_intrusive_pool& operator=(boost_intrusive_pool&& other) = delete;
+    sharded_boost_intrusive_pool& operator=(sharded_boost_intrusive_pool&& other) = delete;
 
     //------------------------------------------------------------------------------
     // configuration/initialization methods
+    // These are NOT thread-safe: they must be invoked before sharing the pool with other threads.
     //------------------------------------------------------------------------------
 
     bool init(size_t init_size = BOOST_INTRUSIVE_POOL_DEFAULT_POOL_SIZE,
         size_t enlarge_size = BOOST_INTRUSIVE_POOL_INCREASE_STEP, size_t max_size = BOOST_INTRUSIVE_POOL_NO_MAX_SIZE,
-        recycle_method_e recycle_method = RECYCLE_METHOD_NONE, recycle_function recycle_fn = nullptr)
+        recycle_method_e recycle_method = RECYCLE_METHOD_NONE, recycle_function recycle_fn = nullptr,
+        size_t num_shards = 0, memory_backing_e memory_backing = MEMORY_BACKING_DEFAULT,
+        boost_intrusive_pool_memory_source* memory_source = nullptr)
     {
         assert(m_pool == nullptr); // cannot initialize twice the memory pool
         assert(init_size > 0);
         assert((max_size == BOOST_INTRUSIVE_POOL_NO_MAX_SIZE) || (max_size >= init_size && enlarge_size > 0));
 
-        m_pool = boost::intrusive_ptr<impl>(new impl(enlarge_size, max_size, recycle_method, recycle_fn));
+        if (num_shards == 0)
+            num_shards = std::thread::hardware_concurrency();
+        if (num_shards == 0)
+            num_shards = 1; // the number of CPUs is not computable
 
-        // do initial malloc
-        return m_pool->enlarge(init_size);
+        m_pool = boost::intrusive_ptr<impl>(
+            new impl(num_shards, enlarge_size, max_size, recycle_method, recycle_fn, memory_backing, memory_source));
+
+        // do initial malloc, spreading the items over all shards
+        std::lock_guard<std::mutex> lock(m_pool->m_enlarge_mutex);
+        return m_pool->enlarge(init_size, 0, std::min(num_shards, init_size));
     }
 
     void set_recycle_method(recycle_method_e method, recycle_function recycle_fn = nullptr)
@@ -387,19 +3934,28 @@ public:
         m_pool->set_recycle_method(method, recycle_fn);
     }
 
+    // Selects how many items each enlarge step adds to the pool: see boost_intrusive_pool::set_growth_policy()
+    template <typename GrowthPolicy> void set_growth_policy(GrowthPolicy growth_fn)
+    {
+        assert(m_pool); // pool must be initialized
+        std::lock_guard<std::mutex> lock(m_pool->m_enlarge_mutex);
+        m_pool->m_growth.set_policy(growth_fn, boost_intrusive_pool_growth_uses_elapsed_time<GrowthPolicy>::value);
+    }
+
     //------------------------------------------------------------------------------
     // allocate method variants
+    // These are all thread-safe.
     //------------------------------------------------------------------------------
 
-    // Returns the first available free item.
+    // Returns the first available free item of the shard of the current CPU.
     item_ptr allocate()
     {
         assert(m_pool); // pool must be initialized
         Item* recycled_item = m_pool->allocate_safe_get_recycled_item();
         if (!recycled_item)
             return nullptr;
-
-        // in this case we don't need to call ANY function
+        if (m_pool->has_raw_slots())
+            boost_intrusive_pool_construct(recycled_item);
 
         item_ptr ret_ptr(recycled_item);
 #if BOOST_INTRUSIVE_POOL_DEBUG_CHECKS
@@ -418,11 +3974,8 @@ public:
         if (!recycled_item)
             return nullptr;
 
-        // Construct the object in the obtained storage
-        // using the init() method of the item itself:
-        recycled_item->init(std::forward<Args>(args)...);
+        boost_intrusive_pool_init(recycled_item, m_pool->has_raw_slots(), std::forward<Args>(args)...);
 
-        // AFTER the init() call, run the check() function
         item_ptr ret_ptr(recycled_item);
 #if BOOST_INTRUSIVE_POOL_DEBUG_CHECKS
         ret_ptr->check();
@@ -431,25 +3984,23 @@ public:
     }
 
     // Returns first available free item or, if necessary and the memory pool is unbounded,
-    // allocates a new item.
-    template <typename... Args> item_ptr allocate_through_function(allocate_function fn)
+    // allocates a new item. The given callable is invoked directly (and can be inlined) on the item.
+    template <typename Function> item_ptr allocate_through_function(Function&& fn)
     {
         assert(m_pool); // pool must be initialized
         Item* recycled_item = m_pool->allocate_safe_get_recycled_item();
         if (!recycled_item)
             return nullptr;
 
-        // Construct the object in the obtained storage
-        // uses perfect forwarding to the class ctor:
-        /// new (recycled_item) Item(std::forward<Args>(args)...);
+        if (m_pool->has_raw_slots())
+            boost_intrusive_pool_construct(recycled_item);
+        uint32_t shard = boost_intrusive_pool_save_header(recycled_item);
         fn(*recycled_item);
 
-        // relinking the item to the pool is instead a critical step: we just executed
-        // the ctor of the recycled item; that resulted in a call to
-        // boost_intrusive_pool_item::boost_intrusive_pool_item()!
-        recycled_item->_refcounted_item_set_pool(m_pool);
+        // the function may run the ctor of the item again, which resets its header, including the shard the item
+        // must return to: see boost_intrusive_pool::allocate_through_function()
+        boost_intrusive_pool_restore_header(recycled_item, shard);
 
-        // AFTER the ctor call, run the check() function
         item_ptr ret_ptr(recycled_item);
 #if BOOST_INTRUSIVE_POOL_DEBUG_CHECKS
         ret_ptr->check();
@@ -461,26 +4012,8 @@ public:
     // other functions operating on items
     //------------------------------------------------------------------------------
 
-    void clear()
-    {
-        if (!m_pool)
-            return; // nothing to do
-
-        // VERY IMPORTANT: this function is very tricky: to do this correctly we cannot
-        // simply call m_pool->clear(): that would remove all arenas that are the memory
-        // support of memory pool items.
-        // At this point we don't know yet if there are boost::intrusive_ptr<> out there
-        // still alive... so we must play safe:
-        size_t init_size = m_pool->m_enlarge_step;
-        size_t enlarge_size = m_pool->m_enlarge_step;
-        size_t max_size = m_pool->m_max_size;
-        recycle_method_e method = m_pool->m_recycle_method;
-        recycle_function recycle = m_pool->m_recycle_fn;
-        m_pool->trigger_self_destruction();
-        m_pool = nullptr; // release old pool
-        m_pool = boost::intrusive_ptr<impl>(new impl(enlarge_size, max_size, method, recycle));
-    }
-
+    // Verifies the integrity of the memory pool.
+    // NOTE: results are meaningful only if no other thread is using the memory pool at the same time.
     void check()
     {
         if (!m_pool)
@@ -490,6 +4023,7 @@ public:
 
     //------------------------------------------------------------------------------
     // getters
+    // NOTE: when other threads are using the memory pool, these only provide a snapshot of its status.
     //------------------------------------------------------------------------------
 
     // returns true if there are no elements in use.
@@ -516,281 +4050,302 @@ public:
     // returns the number of mallocs done so far
     size_t enlarge_steps_done() const { return m_pool ? m_pool->enlarge_steps_done() : 0; }
 
+    // returns the number of bytes of arena memory obtained from huge pages: zero unless the pool has been created with
+    // MEMORY_BACKING_HUGE_PAGES and huge pages are available
+    size_t huge_page_memory() const { return m_pool ? m_pool->huge_page_memory() : 0; }
+
+    // returns the number of bytes of arena memory locked in RAM: zero unless the pool has been created with
+    // MEMORY_BACKING_LOCKED and the RLIMIT_MEMLOCK limit allows locking its arenas
+    size_t locked_memory() const { return m_pool ? m_pool->locked_memory() : 0; }
+
+    // returns the number of items whose memory is bound to the given NUMA node: zero unless the pool has been created
+    // with MEMORY_BACKING_NUMA_LOCAL or with a memory source binding its memory to that node (see
+    // boost_intrusive_pool_numa_memory_source) and the machine supports NUMA
+    size_t numa_node_capacity(int node) const { return m_pool ? m_pool->numa_node_capacity(node) : 0; }
+
+    size_t num_shards() const { return m_pool ? m_pool->m_num_shards : 0; }
+
+    // returns the number of free items of the given shard
+    size_t shard_unused_count(size_t shard) const { return m_pool ? m_pool->shard_unused_count(shard) : 0; }
+
 private:
-    /// The actual pool implementation. We use the
-    /// enable_shared_from_this helper to make sure we can pass a
-    /// "back-pointer" to the pooled objects. The idea behind this
-    /// is that we need objects to be able to add themselves back
-    /// into the pool once they go out of scope.
+    /// The actual pool implementation.
+    /// Each shard is a lock-free free list plus the number of items allocated out of it; each item records the
+    /// shard it has been allocated from, so that it goes back to the same shard when recycled.
+    /// The list of arenas is instead protected by a mutex which is taken only when the pool needs to be enlarged.
     class impl : public boost_intrusive_pool_iface {
     public:
-        impl(size_t enlarge_size, size_t max_size, recycle_method_e method, recycle_function recycle)
+        impl(size_t num_shards, size_t enlarge_size, size_t max_size, recycle_method_e method,
+            recycle_function recycle, memory_backing_e memory_backing,
+            boost_intrusive_pool_memory_source* memory_source)
         {
-            // assert(enlarge_size > 0); // NOTE: enlarge_size can be zero to create a limited-size memory pool
+            assert(num_shards > 0 && num_shards <= UINT32_MAX);
 
             // configurations
-            m_recycle_method = method;
-            m_recycle_fn = recycle;
+            // items without a default ctor can be constructed only when they get allocated:
+            assert(std::is_default_constructible<Item>::value || method == RECYCLE_METHOD_DTOR);
+            m_recycle_method = std::is_default_constructible<Item>::value ? method : RECYCLE_METHOD_DTOR;
+            boost_intrusive_pool_configure_recycle(m_recycle_policy, m_recycle_method, recycle);
             m_enlarge_step = enlarge_size;
             m_max_size = max_size;
+            m_memory_backing = memory_backing;
+            m_memory_source = memory_source;
+            m_num_shards = num_shards;
 
             // status
-            m_first_free_item = nullptr;
+            m_shards.reset(new shard[num_shards]);
             m_first_arena = nullptr;
             m_last_arena = nullptr;
-            m_memory_exhausted = false;
-            m_trigger_self_destruction = false;
+            m_memory_exhausted.store(false);
+            m_orphan_inuse_count.store(0);
 
             // stats
-            m_free_count = 0;
-            m_inuse_count = 0;
-            m_total_count = 0;
-
-#if BOOST_INTRUSIVE_POOL_DEBUG_THREAD_ACCESS
-            m_allowed_thread = 0;
-#endif
+            m_total_count.store(0);
+            m_num_enlarge_steps.store(0);
+            m_huge_page_memory.store(0);
+            m_locked_memory.store(0);
+            for (std::atomic<size_t>& capacity : m_numa_capacity)
+                capacity.store(0);
         }
 
         ~impl()
         {
             // if this dtor is called, it means that all memory pooled items have been destroyed:
-            // they are holding a shared_ptr<> back to us, so if one of them was alive, this dtor would not be called!
-            clear();
+            // m_orphan_reference is held on their behalf, so if one of them was alive, this dtor would not be called!
+            boost_intrusive_pool_arena<Item>* pcurr = m_first_arena;
+            while (pcurr) {
+                boost_intrusive_pool_arena<Item>* pnext = pcurr->get_next_arena();
+                delete pcurr;
+                pcurr = pnext;
+            }
         }
 
         void set_recycle_method(recycle_method_e method, recycle_function recycle = nullptr)
         {
+            // the arenas contain either constructed items or raw storage, depending on RECYCLE_METHOD_DTOR:
+            assert((method == RECYCLE_METHOD_DTOR) == has_raw_slots());
             m_recycle_method = method;
-            m_recycle_fn = recycle;
+            boost_intrusive_pool_configure_recycle(m_recycle_policy, method, recycle);
         }
 
-        void trigger_self_destruction()
+        // returns true if free items are just raw storage where items get constructed when they are allocated
+        bool has_raw_slots() const
         {
-            m_trigger_self_destruction = true;
+            return boost_intrusive_pool_is_runtime_recycle<RecyclePolicy, Item>::value
+                && m_recycle_method == RECYCLE_METHOD_DTOR;
+        }
 
-            // walk over the free list and reduce our own refcount by removing the link between the items and ourselves:
-            // this is important because it allows the last item that will return to this pool to trigger the pool
-            // dtor: see recycle() implementation
-            boost_intrusive_pool_item* pcurr = m_first_free_item;
-            while (pcurr) {
-                pcurr->_refcounted_item_set_pool(nullptr);
-                pcurr = pcurr->_refcounted_item_get_next();
+        // free items are converted into items without static_cast<> when they are just raw storage
+        Item* item_of(boost_intrusive_pool_item* p) const
+        {
+            if (has_raw_slots())
+                return boost_intrusive_pool_arena<Item>::slot_of(p);
+            return boost_intrusive_pool_downcast<Item>(p);
+        }
+
+        void trigger_self_destruction()
+        {
+            // NOTE: see concurrent_boost_intrusive_pool::impl::trigger_self_destruction()
+            m_orphan_reference = this;
+
+            // Mark the counter of each shard as orphan and move the number of items in use out of that shard into
+            // a single counter: the thread bringing it to zero releases the last reference to this pool.
+            // The counter starts from k_orphan_flag so that it cannot reach zero before all shards have been visited
+            // (the number of items in use is always much smaller).
+            m_orphan_inuse_count.store(k_orphan_flag, std::memory_order_relaxed);
+            for (size_t i = 0; i < m_num_shards; i++) {
+                size_t inuse = m_shards[i].m_inuse_count.fetch_or(k_orphan_flag, std::memory_order_acq_rel);
+                m_orphan_inuse_count.fetch_add(inuse, std::memory_order_relaxed);
             }
+            if (m_orphan_inuse_count.fetch_sub(k_orphan_flag, std::memory_order_acq_rel) == k_orphan_flag)
+                release_orphan_reference();
+        }
+
+        void release_orphan_reference()
+        {
+            boost_intrusive_pool_iface_ptr last_reference;
+            last_reference.swap(m_orphan_reference); // this is likely to trigger impl::~impl()
         }
 
+        // NOTE: m_enlarge_mutex must be locked by the caller
         size_t get_effective_enlarge_step() const
         {
-            size_t enlarge_step = m_enlarge_step;
-            if (m_enlarge_step > 0 && (m_max_size > 0 && (m_total_count + m_enlarge_step > m_max_size)))
-                enlarge_step = m_max_size - m_total_count; // enlarge_step can be zero if we reach the max_size
+            if (m_enlarge_step == 0)
+                return 0;
+            size_t total_count = m_total_count.load(std::memory_order_relaxed);
+            size_t enlarge_step = m_growth.get_next_step(
+                m_enlarge_step, total_count, m_num_enlarge_steps.load(std::memory_order_relaxed));
+            if (m_max_size > 0 && total_count + enlarge_step > m_max_size)
+                enlarge_step = m_max_size - total_count; // enlarge_step can be zero if we reach the max_size
             return enlarge_step;
         }
 
+        size_t get_current_shard() const { return boost_intrusive_pool_get_current_cpu() % m_num_shards; }
+
         Item* allocate_safe_get_recycled_item()
         {
-#if BOOST_INTRUSIVE_POOL_DEBUG_THREAD_ACCESS
-            if (m_allowed_thread == 0)
-                m_allowed_thread = pthread_self();
-            else
-                assert(m_allowed_thread == pthread_self());
-#endif
-
-            if (m_free_count == 0) {
-                assert(m_first_free_item == nullptr);
-                size_t enlarge_step = get_effective_enlarge_step();
-                if (enlarge_step == 0 || !enlarge(enlarge_step)) {
-                    m_memory_exhausted = true;
+            size_t shard_idx = get_current_shard();
+            shard& current = m_shards[shard_idx];
+
+            boost_intrusive_pool_item* pitem = current.m_free_list.pop();
+            if (pitem == nullptr) {
+                // slow path: the shard of this CPU is empty
+                pitem = steal_or_enlarge(shard_idx);
+                if (pitem == nullptr)
                     return nullptr; // allocation by enlarge() failed or this is a fixed-size memory pool!
-                }
             }
 
-            // get first item from free list
-            assert(m_first_free_item != nullptr);
-            Item* recycled_item = dynamic_cast<Item*>(m_first_free_item); // downcast (base class -> derived class)
-            assert(recycled_item != nullptr); // we always allocate all items of the same type,
-                                              // so the dynamic cast cannot fail
-            assert(
-                recycled_item->_refcounted_item_get_pool().get() == this); // this was set during arena initialization
-                                                                           // and must be valid at all times
-
-            // update stats
-            m_free_count--;
-            m_inuse_count++;
-
-            // update the pointer to the next free item available
-            m_first_free_item = m_first_free_item->_refcounted_item_get_next();
-            if (m_first_free_item == nullptr && m_enlarge_step > 0) {
-                size_t enlarge_step = get_effective_enlarge_step();
-                if (enlarge_step == 0) { // enlarge_step can be zero if we reach the max_size
-                    m_memory_exhausted = true;
-                } else {
-                    // this is a memory pool which can be still enlarged:
-                    // exit the function leaving the m_first_free_item as a valid pointer to a free item!
-                    // this is just to simplify debugging and make more effective the check() function implementation!
-
-                    assert(m_free_count == 0);
-                    if (!enlarge(enlarge_step)) {
-                        m_memory_exhausted = true;
-                        // We tried to fetch memory from the O.S. but we failed. However we succeeded in getting the
-                        // last available item. So fallback and provide that last item to the caller.
-                    }
-                }
-            }
+            pitem->_refcounted_item_set_shard(shard_idx);
+            current.m_inuse_count.fetch_add(1, std::memory_order_relaxed);
 
-            // unlink the item to return
-            recycled_item->_refcounted_item_set_next(nullptr);
-            return recycled_item;
+            assert(pitem->_refcounted_item_get_pool() == this);
+            assert(pitem->_refcounted_item_get_next() == nullptr); // pop() unlinks the item
+            return item_of(pitem);
         }
 
-        bool enlarge(size_t arena_size)
+        // Tries to move a batch of free items from the other shards into the given one, visiting first its
+        // neighbours; enlarges the pool only if all shards are empty.
+        // Returns one of the items obtained, already unlinked from the free list.
+        boost_intrusive_pool_item* steal_or_enlarge(size_t shard_idx)
         {
-#if BOOST_INTRUSIVE_POOL_DEBUG_THREAD_ACCESS
-            assert(m_allowed_thread == 0 || m_allowed_thread == pthread_self());
-#endif
-            // If the current arena is full, create a new one.
-            boost_intrusive_pool_arena<Item>* new_arena = new boost_intrusive_pool_arena<Item>(arena_size, this);
-            if (!new_arena)
-                return false; // malloc failed... memory finished... very likely this is a game over
-
-            // Link the new arena to the last one.
-            if (m_last_arena)
-                m_last_arena->set_next_arena(new_arena);
-            if (m_first_arena == nullptr)
-                m_first_arena = new_arena; // apparently we are initializing the memory pool for the very first time
+            shard& current = m_shards[shard_idx];
+            while (true) {
+                for (size_t i = 1; i < m_num_shards; i++) {
+                    shard& victim = m_shards[(shard_idx + i) % m_num_shards];
+                    size_t count;
+                    boost_intrusive_pool_item* first
+                        = victim.m_free_list.pop_chain(BOOST_INTRUSIVE_POOL_SHARD_STEAL_BATCH, count);
+                    if (first == nullptr)
+                        continue;
+
+                    // keep the first item for the caller and move the others into the shard of this CPU:
+                    boost_intrusive_pool_item* others = first->_refcounted_item_get_next();
+                    first->_refcounted_item_set_next(nullptr);
+                    if (others) {
+                        boost_intrusive_pool_item* last = others;
+                        while (last->_refcounted_item_get_next())
+                            last = last->_refcounted_item_get_next();
+                        current.m_free_list.push_chain(others, last);
+                    }
+                    return first;
+                }
 
-            // Seek pointer to last arena
-            m_last_arena = new_arena;
+                // all shards are empty:
+                std::lock_guard<std::mutex> lock(m_enlarge_mutex);
+                boost_intrusive_pool_item* pitem = current.m_free_list.pop();
+                if (pitem)
+                    return pitem; // some other thread has recycled items or enlarged the pool meanwhile
 
-            // Update the free_list with the storage of the just created arena.
-            if (m_first_free_item == nullptr)
-                m_first_free_item = m_last_arena->get_first_item();
+                size_t enlarge_step = get_effective_enlarge_step();
+                if (enlarge_step == 0 || !enlarge(enlarge_step, shard_idx, 1)) {
+                    m_memory_exhausted.store(true, std::memory_order_relaxed);
+                    return nullptr;
+                }
 
-            m_free_count += arena_size;
-            m_total_count += arena_size;
+                pitem = current.m_free_list.pop();
+                if (pitem)
+                    return pitem;
+                // all new items have been stolen by other shards meanwhile... try again
+            }
+        }
 
+        // Creates a new arena and spreads its items evenly over "num_shards_to_fill" shards starting from
+        // "first_shard".
+        // NOTE: m_enlarge_mutex must be locked by the caller
+        bool enlarge(size_t arena_size, size_t first_shard, size_t num_shards_to_fill)
+        {
+            assert(num_shards_to_fill > 0 && num_shards_to_fill <= arena_size);
+
+            // If the last arena has no room for the new items, create a new one.
+            if (!m_last_arena || m_last_arena->get_free_slot_count() < arena_size) {
+                // NOTE: segment indexes are used only by memory pools of compact items
+                boost_intrusive_pool_arena<Item>* new_arena
+                    = boost_intrusive_pool_arena<Item>::create(arena_size, this, 0, m_memory_backing, m_memory_source);
+                if (!new_arena)
+                    return false; // malloc failed... memory finished... very likely this is a game over
+                if (!boost_intrusive_pool_lockfree_stack::can_hold(
+                        new_arena->get_segment(0), new_arena->get_memory_size())) {
+                    delete new_arena; // its items could not be linked into the free lists
+                    return false;
+                }
+                if (new_arena->is_on_huge_pages())
+                    m_huge_page_memory.fetch_add(new_arena->get_memory_size(), std::memory_order_relaxed);
+                if (new_arena->is_locked())
+                    m_locked_memory.fetch_add(new_arena->get_memory_size(), std::memory_order_relaxed);
+
+                // Link the new arena to the last one.
+                if (m_last_arena)
+                    m_last_arena->set_next_arena(new_arena);
+                else
+                    m_first_arena = new_arena; // apparently we are initializing the memory pool for the very first time
+                m_last_arena = new_arena;
+            }
+            boost_intrusive_pool_item* new_items = m_last_arena->add_items(arena_size, has_raw_slots());
+            if (m_last_arena->get_numa_node() >= 0)
+                m_numa_capacity[m_last_arena->get_numa_node()].fetch_add(arena_size, std::memory_order_relaxed);
+
+            m_total_count.fetch_add(arena_size, std::memory_order_relaxed);
+            m_num_enlarge_steps.fetch_add(1, std::memory_order_relaxed);
+            m_growth.enlarged(arena_size);
+
+            // split the chain of new items in contiguous pieces and publish each of them at once
+            boost_intrusive_pool_item* pcurr = new_items;
+            for (size_t i = 0; i < num_shards_to_fill; i++) {
+                size_t count = arena_size / num_shards_to_fill + ((i < arena_size % num_shards_to_fill) ? 1 : 0);
+
+                boost_intrusive_pool_item* first = pcurr;
+                boost_intrusive_pool_item* last = pcurr;
+                for (size_t j = 1; j < count; j++)
+                    last = last->_refcounted_item_get_next();
+                pcurr = last->_refcounted_item_get_next();
+                last->_refcounted_item_set_next(nullptr);
+
+                m_shards[(first_shard + i) % m_num_shards].m_free_list.push_chain(first, last);
+            }
+            assert(pcurr == nullptr);
             return true;
         }
 
         virtual void recycle(boost_intrusive_pool_item* pitem_base) override
         {
-#if BOOST_INTRUSIVE_POOL_DEBUG_THREAD_ACCESS
-            assert(m_allowed_thread != 0);
-            assert(m_allowed_thread == pthread_self());
-#endif
             assert(pitem_base
                 && pitem_base->_refcounted_item_get_next()
                     == nullptr); // Recycling an item that has been already recycled?
-            assert(pitem_base->_refcounted_item_get_pool().get() == this);
-
-            Item* pitem = dynamic_cast<Item*>(pitem_base); // downcast (base class -> derived class)
-            assert(pitem != nullptr); // we always allocate all items of the same type,
-                                      // so the dynamic cast cannot fail
-            switch (m_recycle_method) {
-            case RECYCLE_METHOD_NONE:
-                break;
-
-            case RECYCLE_METHOD_DESTROY_FUNCTION:
-                pitem->destroy();
-                break;
-
-            case RECYCLE_METHOD_CUSTOM_FUNCTION:
-                m_recycle_fn(*pitem);
-                break;
-
-                // the big problem with using the class destructor is that the virtual table of the item will
-                // be destroyed; attempting to dynamic_cast<> the item later will fail (NULL returned).
-                // so this recycling option is disabled for now
-                // case RECYCLE_METHOD_DTOR:
-                // Destroy the object using its dtor:
-                // pitem->Item::~Item();
-                // break;
-            }
-
-            // sanity check:
-            if (!is_bounded()) {
-                assert(m_first_free_item != nullptr || m_memory_exhausted);
-            }
+            assert(pitem_base->_refcounted_item_get_pool() == this);
+            assert(pitem_base->_refcounted_item_get_shard() < m_num_shards);
 
-            // Add the item at the beginning of the free list.
-            pitem_base->_refcounted_item_set_next(m_first_free_item);
-            m_first_free_item = pitem_base;
-            m_free_count++;
-
-            assert(m_inuse_count > 0);
-            m_inuse_count--;
-
-#if BOOST_INTRUSIVE_POOL_DEBUG_CHECKS
-            pitem_base->check();
-#endif
+            m_recycle_policy(*boost_intrusive_pool_downcast<Item>(pitem_base));
 
-            // test for self-destruction:
-            // is this an orphan pool (i.e. a pool without any boost_intrusive_pool<> associated to it anymore)?
-            if (m_trigger_self_destruction) {
-                // in such case break the link between the items being recycled and this pool:
-                // in this way the very last memory-pooled item returning to this pool will lower the refcount
-                // to this pool to zero, and impl::~impl() will get called, freeing all arenas!
-                pitem->_refcounted_item_set_pool(nullptr);
-            }
-        }
-
-        //------------------------------------------------------------------------------
-        // other functions operating on items
-        //------------------------------------------------------------------------------
+            // Add the item at the beginning of the free list of the shard it has been allocated from.
+            shard& owner = m_shards[pitem_base->_refcounted_item_get_shard()];
+            owner.m_free_list.push(pitem_base);
 
-        // THIS IS A SUPER DANGEROUS FUNCTION: IT JUST REMOVES ALL ARENAS OF THIS MEMORY POOL WITHOUT ANY
-        // CHECK WHETHER THERE ARE boost::intrusive_ptr<> OUT THERE STILL POINTING TO ITEMS INSIDE THOSE
-        // ARENAS. USE
-        void clear()
-        {
-            if (m_first_arena) {
-                size_t init_size = m_first_arena->get_stored_item_count();
-                boost_intrusive_pool_arena<Item>* pcurr = m_first_arena;
-                while (pcurr) {
-                    boost_intrusive_pool_arena<Item>* pnext = pcurr->get_next_arena();
-                    delete pcurr;
-                    pcurr = pnext;
-                }
-            } else {
-                // this memory pool has just been clear()ed... the last arena pointer should be null as well:
-                assert(m_last_arena == nullptr);
+            // test for self-destruction: see concurrent_boost_intrusive_pool::impl::push_to_free_list()
+            // If the shard was already marked as orphan, this item has been counted by m_orphan_inuse_count, which
+            // thus cannot drop to zero before the decrement below: the pool is still alive.
+            if (owner.m_inuse_count.fetch_sub(1, std::memory_order_acq_rel) & k_orphan_flag) {
+                if (m_orphan_inuse_count.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                    release_orphan_reference();
             }
-
-            // status
-            m_first_free_item = nullptr;
-            m_first_arena = nullptr;
-            m_last_arena = nullptr;
-            m_memory_exhausted = false;
-
-            // stats
-            m_free_count = 0;
-            m_inuse_count = 0;
-            m_total_count = 0;
         }
 
         void check()
         {
+            size_t total_count = m_total_count.load();
             if (m_first_arena) {
                 // this memory pool has been correctly initialized
                 assert(m_last_arena);
-                assert(m_total_count > 0);
+                assert(total_count > 0);
 
-                // this condition should hold at any time:
-                assert(m_free_count + m_inuse_count == m_total_count);
-                if (is_bounded()) {
-                    // when the memory pool is bounded it contains only 1 arena of a fixed size:
-                    assert(m_first_arena == m_last_arena);
-                } else {
-                    // infinite or max size memory pool: either we have a valid free element or the last malloc() must
-                    // have failed or the maximum size has been reached:
-                    assert(m_first_free_item != nullptr || m_memory_exhausted);
-                }
+                // this condition holds as long as no other thread is using the pool:
+                size_t free_count = 0;
+                for (size_t i = 0; i < m_num_shards; i++)
+                    free_count += m_shards[i].m_free_list.unsafe_size();
+                assert(free_count + inuse_count() == total_count);
             } else {
-                // this memory pool has just been cleared with clear() apparently:
                 assert(!m_last_arena);
-                assert(!m_first_free_item);
-                assert(m_free_count == 0);
-                assert(m_inuse_count == 0);
-                assert(m_total_count == 0);
+                assert(inuse_count() == 0);
+                assert(total_count == 0);
             }
         }
 
@@ -798,91 +4353,100 @@ private:
         // getters
         //------------------------------------------------------------------------------
 
-        // returns true if there are no elements in use.
-        // Note that if empty()==true, it does not mean that capacity()==0 as well!
-        bool empty() const { return m_free_count == m_total_count; }
+        bool empty() const { return inuse_count() == 0; }
 
         bool is_bounded() const { return m_enlarge_step == 0; }
 
         bool is_limited() const { return (m_enlarge_step == 0 || m_max_size != 0); }
 
-        bool can_be_enlarged() const { return m_enlarge_step > 0 && (m_max_size == 0 || m_total_count < m_max_size); }
+        bool is_memory_exhausted() const { return m_memory_exhausted.load(std::memory_order_relaxed); }
 
-        bool is_memory_exhausted() const { return m_memory_exhausted; }
+        size_t capacity() const { return m_total_count.load(std::memory_order_relaxed); }
 
-        // returns the current (=maximum) capacity of the object pool
-        size_t capacity() const { return m_total_count; }
+        size_t max_size() const { return (m_enlarge_step != 0) ? m_max_size : capacity(); }
 
-        size_t max_size() const { return (m_enlarge_step != 0) ? m_max_size : m_total_count; }
+        size_t unused_count() const
+        {
+            size_t total_count = m_total_count.load(std::memory_order_relaxed);
+            size_t inuse = inuse_count();
+            return (inuse < total_count) ? total_count - inuse : 0;
+        }
 
-        // returns the number of free entries of the pool
-        size_t unused_count() const { return m_free_count; }
+        size_t inuse_count() const
+        {
+            size_t inuse = 0;
+            for (size_t i = 0; i < m_num_shards; i++)
+                inuse += m_shards[i].m_inuse_count.load(std::memory_order_relaxed) & ~k_orphan_flag;
+            return inuse;
+        }
 
-        // returns the number of items currently malloc()ed from this pool
-        size_t inuse_count() const { return m_inuse_count; }
+        size_t enlarge_steps_done() const { return m_num_enlarge_steps.load(std::memory_order_relaxed); }
 
-        // returns the number of mallocs done so far
-        size_t enlarge_steps_done() const
+        size_t huge_page_memory() const { return m_huge_page_memory.load(std::memory_order_relaxed); }
+        size_t locked_memory() const { return m_locked_memory.load(std::memory_order_relaxed); }
+        size_t numa_node_capacity(int node) const
         {
-            size_t num_arenas_allocated = 0;
-
-            const boost_intrusive_pool_arena<Item>* pcurr = m_first_arena;
-            while (pcurr) {
-                pcurr = pcurr->get_next_arena();
-                num_arenas_allocated++;
-            }
+            if (node < 0 || node >= BOOST_INTRUSIVE_POOL_MAX_NUMA_NODES)
+                return 0;
+            return m_numa_capacity[node].load(std::memory_order_relaxed);
+        }
 
-            return num_arenas_allocated;
+        // NOTE: this walks the free list of the shard, so it is meaningful only if no other thread is using it
+        size_t shard_unused_count(size_t shard_idx) const
+        {
+            assert(shard_idx < m_num_shards);
+            return m_shards[shard_idx].m_free_list.unsafe_size();
         }
 
     public:
+        struct shard {
+            shard() { m_inuse_count.store(0); }
+
+            // List of free elements: lock-free, since threads can be migrated to another CPU at any time.
+            boost_intrusive_pool_lockfree_stack m_free_list;
+
+            // Number of items allocated out of this shard and not yet recycled; the highest bit is set once the
+            // pool is orphan.
+            std::atomic<size_t> m_inuse_count;
+
+            // keep the shards of different CPUs on different cache lines
+            char m_padding[BOOST_INTRUSIVE_POOL_CACHE_LINE_SIZE];
+        };
+
         // The recycle strategy & function
         recycle_method_e m_recycle_method;
-        recycle_function m_recycle_fn;
+        RecyclePolicy m_recycle_policy;
 
-        // How many new items to add each time the pool becomes full?
-        // If this is zero, then this is a bounded pool, which cannot grow beyond
-        // the initial size provided at construction time.
+        // See boost_intrusive_pool::impl for the meaning of these configurations
         size_t m_enlarge_step;
-        // Maximum pool size.
-        // If this is zero, then it is ignored.
-        // If this is greater then zero, then no more items will be added to the pull if resulting size would exceed
-        // this value. If enlarge_step is zero, the max_size parameter become meaningless.
         size_t m_max_size;
+        boost_intrusive_pool_growth_state m_growth; // protected by m_enlarge_mutex
+        memory_backing_e m_memory_backing;
+        boost_intrusive_pool_memory_source* m_memory_source;
 
-        // Pointers to first and last arenas.
-        // First arena is changed only at
-        //  - construction time
-        //  - in clear()
-        //  - in reset(size_t)
-        // Pointer to last arena is instead updated on every enlarge step.
+        // Shards: one for each CPU
+        size_t m_num_shards;
+        std::unique_ptr<shard[]> m_shards;
+
+        // Arenas list: protected by m_enlarge_mutex
+        std::mutex m_enlarge_mutex;
         boost_intrusive_pool_arena<Item>* m_first_arena;
         boost_intrusive_pool_arena<Item>* m_last_arena;
 
-        // List of free elements. The list can be threaded between different arenas
-        // depending on the deallocation pattern.
-        // This pointer can be NULL only whether:
-        // - an infinite memory pool has exhausted memory (malloc returned NULL);
-        // - a bounded memory pool has exhausted all its items
-        // - a maximum size memory pool has exhausted all its items and reached the limit
-        // In such cases m_memory_exhausted==true
-        boost_intrusive_pool_item* m_first_free_item;
-        // This flag can be true if allocation by enlarge() failed or this is a fixed-size memory pool or this is a
-        // maximum size memory pool!
-        bool m_memory_exhausted;
-
-        // stats
-        // This should hold always:
-        //         m_free_count+m_inuse_count == m_total_count
-        size_t m_free_count;
-        size_t m_inuse_count;
-        size_t m_total_count;
+        std::atomic<bool> m_memory_exhausted;
 
-        bool m_trigger_self_destruction;
+        // Used only once this pool is orphan: see trigger_self_destruction()
+        static constexpr size_t k_orphan_flag = ~(~(size_t)0 >> 1);
+        std::atomic<size_t> m_orphan_inuse_count;
+        boost_intrusive_pool_iface_ptr m_orphan_reference;
 
-#if BOOST_INTRUSIVE_POOL_DEBUG_THREAD_ACCESS
-        pthread_t m_allowed_thread;
-#endif
+        // stats
+        // NOTE: the number of in-use items is the sum of the per-shard counters, to avoid a contended cache line.
+        std::atomic<size_t> m_total_count;
+        std::atomic<size_t> m_num_enlarge_steps;
+        std::atomic<size_t> m_huge_page_memory; // bytes of arena memory backed by huge pages
+        std::atomic<size_t> m_locked_memory; // bytes of arena memory locked with mlock()
+        std::atomic<size_t> m_numa_capacity[BOOST_INTRUSIVE_POOL_MAX_NUMA_NODES]; // items bound to each NUMA node
     };
 
 private:
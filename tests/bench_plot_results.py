@@ -52,10 +52,42 @@ def plot_graphs(outfilename, benchmark_dict, title):
     plotlib.savefig(outfilename)
     plotlib.show()
 
+def plot_latency_cdfs(outfilename, pattern, latency_name, title):
+    """Plots the cumulative distribution of the latencies of each implementation, for each run of the given pattern
+    """
+    plotlib.clf()
+    plotlib.xlabel('Latency [nsec]')
+    plotlib.ylabel('Fraction of operations')
+    plotlib.title(title)
+
+    # each implementation gets its own colour, each run its own line style
+    linestyles = ('-', '--', '-.', ':')
+    num_runs = len(pattern)-1 # one entry is the pattern type
+    for run_idx in range(1,num_runs+1):
+        run = pattern["run_" + str(run_idx)]
+        for nimpl, impl_name in enumerate(implementations(run)):
+            latency = run[impl_name][latency_name]
+            label = "%s, run %d (p99=%d, max=%d)" % (impl_name, run_idx, latency['p99'], latency['max'])
+            lines = plotlib.semilogx(latency['cdf_nsec'], latency['cdf_fraction'],
+                                     linestyles[(run_idx-1) % len(linestyles)], label=label)
+            plotlib.setp(lines, 'color', colours[nimpl % len(colours)])
+    plotlib.grid(True)
+    plotlib.ylim(0, 1.05)
+
+    print("Writing plot into '%s'" % outfilename)
+    plotlib.legend(loc='lower right', fontsize='small')
+    plotlib.savefig(outfilename)
+    plotlib.show()
+
+def implementations(run):
+    """Returns the names of the implementations having results in the given run, e.g. plain_malloc or boost_pool
+    """
+    return sorted([ key for key in run.keys() if isinstance(run[key], dict) and 'duration_nsec_per_item' in run[key] ])
+
 def load_pattern(pattern):
-    bm = {}
-    bm['boost_intrusive_pool'] = []
-    bm['plain_malloc'] = []
+    bm = collections.OrderedDict()
+    for impl_name in implementations(pattern["run_1"]):
+        bm[impl_name] = []
     num_items = []
     
     num_runs = len(pattern)-1 # one entry is the pattern type
@@ -66,8 +98,8 @@ def load_pattern(pattern):
         
         # each different line must be a different key in the dictionary
         # each key in the dict can have multiple data points:
-        bm['boost_intrusive_pool'].append(BenchmarkPoint(run['boost_intrusive_pool']['duration_nsec_per_item'], run['enlarge_step']))
-        bm['plain_malloc'].append(BenchmarkPoint(run['plain_malloc']['duration_nsec_per_item'], run['enlarge_step']))
+        for impl_name in bm.keys():
+            bm[impl_name].append(BenchmarkPoint(run[impl_name]['duration_nsec_per_item'], run['enlarge_step']))
         
     #print(' ...found {} data points in implementation {}...'.format(len(bm[pattern_name]), pattern_name))
     return [ bm, int(min(num_items)), int(max(num_items)) ]
@@ -111,6 +143,15 @@ def main(args):
             
             plot_graphs(outfilename, bm, title)
 
+            # runs saved by older releases of the benchmark have no latency histograms
+            if 'allocate_latency_nsec' in pattern['run_1']['boost_intrusive_pool']:
+                latencies = [ ('allocate_latency_nsec', 'allocation'), ('release_latency_nsec', 'release') ]
+                for latency_name, operation in latencies:
+                    outfilename = "tests/results/" + pattern_name + "_" + operation + "_latency_" + \
+                                  image_output_tag + ".png"
+                    title = image_output_tag + "\n" + desc + "\nLatency of each " + operation
+                    plot_latency_cdfs(outfilename, pattern, latency_name, title)
+
 if __name__ == '__main__':
     main(sys.argv[1:])
 
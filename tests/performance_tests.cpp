@@ -11,14 +11,31 @@
 // Includes
 //------------------------------------------------------------------------------
 
+#include <cmath>
+#include <cstring>
+#include <functional>
 #include <map>
+#include <memory>
+#include <mutex>
+#include <random>
 #include <string>
 #include <sys/resource.h>
 #include <sys/time.h>
+#include <thread>
+#include <type_traits>
 #include <unistd.h>
 #include <unordered_map>
 #include <vector>
 
+#include <boost/pool/object_pool.hpp>
+#include <boost/pool/pool.hpp>
+#if __cplusplus >= 201703L
+#include <memory_resource>
+#define BENCH_HAS_PMR 1
+#else
+#define BENCH_HAS_PMR 0
+#endif
+
 #include "boost_intrusive_pool.hpp"
 #include "json-lib.h"
 #include "performance_timing.h"
@@ -31,6 +48,30 @@ using namespace memorypool;
 
 #define NUM_AVERAGING_RUNS (10)
 
+// number of items each thread keeps alive during the contention benchmark
+#define CONTENTION_WINDOW (16)
+#define CONTENTION_NUM_ITEMS_PER_THREAD (1000000)
+#define CONTENTION_MAGAZINE_SIZE (64)
+
+// number of items allocated/released during the inheritance benchmark
+#define INHERITANCE_NUM_ITEMS (10000000)
+
+// total number of items released during the bulk release benchmark, for each batch size
+#define BULK_NUM_ITEMS (1000000)
+
+// number of items allocated and number of random accesses to them done during the huge pages benchmark
+#define HUGEPAGES_NUM_ITEMS (128 * 1024)
+#define HUGEPAGES_NUM_ACCESSES (10000000)
+
+// number of items allocated during the prefault benchmark
+#define PREFAULT_NUM_ITEMS (32 * 1024)
+
+// the scaling benchmark repeats the contention benchmark for 1..N threads, so it uses less averaging runs
+#define SCALING_NUM_AVERAGING_RUNS (3)
+
+// number of items allocated by each thread, for each allocation pattern, during the multithread benchmark
+#define MULTITHREAD_NUM_ITEMS_PER_THREAD (50000)
+
 typedef enum {
     BENCH_PATTERN_CONTINUOUS_ALLOCATION,
     BENCH_PATTERN_MIXED_ALLOC_FREE,
@@ -80,6 +121,28 @@ public:
 
 typedef boost::intrusive_ptr<LargeObject> HLargeObject;
 
+// A 3-level class hierarchy: the cost of a dynamic_cast<> grows with the depth of the hierarchy
+class DeepObjectLevel1 : public memorypool::boost_intrusive_pool_item {
+public:
+    virtual int level() const { return 1; }
+
+protected:
+    char buf[64];
+};
+
+class DeepObjectLevel2 : public DeepObjectLevel1 {
+public:
+    virtual int level() const override { return 2; }
+};
+
+class DeepObject : public DeepObjectLevel2 {
+public:
+    virtual int level() const override { return 3; }
+    void init() { buf[0] = 'a'; }
+};
+
+typedef boost::intrusive_ptr<DeepObject> HDeepObject;
+
 unsigned long LargeObject::m_ctor_count = 0;
 unsigned long LargeObject::m_dtor_count = 0;
 
@@ -95,22 +158,342 @@ public:
     HLargeObject allocate_through_init() { return HLargeObject(new LargeObject()); }
 };
 
+// The usual workaround to share a boost_intrusive_pool among threads: a mutex around every
+// allocation and every release of the items.
+class MutexPool {
+public:
+    MutexPool(size_t init_size, size_t enlarge_size)
+        : m_pool(init_size, enlarge_size)
+    {
+    }
+
+    HLargeObject allocate_through_init()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_pool.allocate_through_init();
+    }
+    void release(HLargeObject& item)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        item = nullptr;
+    }
+
+private:
+    std::mutex m_mutex;
+    boost_intrusive_pool<LargeObject> m_pool;
+};
+
+template <class PoolUnderTest, class ItemPtr> static void release_item(PoolUnderTest& pool, ItemPtr& item)
+{
+    (void)pool; // the item returns into its pool by itself
+    item = nullptr;
+}
+static void release_item(MutexPool& pool, HLargeObject& item) { pool.release(item); }
+
+//------------------------------------------------------------------------------
+// Memory pools of other libraries:
+//------------------------------------------------------------------------------
+
+class ForeignPool;
+
+// The same fat item, for the memory pools of other libraries: instead of the boost_intrusive_pool_item base class it
+// has just a refcount for boost::intrusive_ptr<> and the pool it must be returned to (unused with std::shared_ptr<>)
+class ForeignLargeObject {
+public:
+    // like the ctor of LargeObject, this leaves the buffer uninitialized also when the item gets value-initialized
+    ForeignLargeObject()
+        : m_refcount(0)
+        , m_pool(nullptr)
+    {
+    }
+
+    void init(uint32_t n = 0) { buf[0] = 'a' + (n & 0x11); }
+
+    char read(int idx) const { return buf[idx]; }
+    void write(int idx, char c) { buf[idx] = c; }
+
+    unsigned int m_refcount;
+    ForeignPool* m_pool;
+
+private:
+    // just some fat buffer:
+    char buf[1024];
+};
+
+typedef boost::intrusive_ptr<ForeignLargeObject> HForeignLargeObject;
+typedef std::shared_ptr<ForeignLargeObject> SForeignLargeObject;
+
+class ForeignPool {
+public:
+    virtual ~ForeignPool() { }
+    virtual void release(ForeignLargeObject* item) = 0;
+};
+
+inline void intrusive_ptr_add_ref(ForeignLargeObject* x) { x->m_refcount++; }
+inline void intrusive_ptr_release(ForeignLargeObject* x)
+{
+    if (--x->m_refcount == 0)
+        x->m_pool->release(x);
+}
+
+// boost::object_pool<>: its destroy() keeps the free list ordered, so its cost grows with the number of free items
+// and releasing all the items of the pool takes quadratic time (minutes with the patterns of this benchmark). Items
+// are thus released in constant time directly into the underlying boost::pool<>, as boost::object_pool<> users do
+// when they cannot just throw away the whole pool. Since the dtor of ForeignLargeObject is trivial, the object_pool
+// dtor can still run on its chunks without knowing which ones are free.
+class BoostObjectPool : public ForeignPool, private boost::object_pool<ForeignLargeObject> {
+public:
+    BoostObjectPool(size_t init_size, size_t enlarge_size)
+        : boost::object_pool<ForeignLargeObject>(init_size)
+    {
+        (void)enlarge_size; // each new chunk is twice as large as the previous one
+    }
+
+    HForeignLargeObject allocate_through_init()
+    {
+        ForeignLargeObject* item = construct();
+        item->init();
+        item->m_pool = this;
+        return HForeignLargeObject(item);
+    }
+    virtual void release(ForeignLargeObject* item) override
+    {
+        item->~ForeignLargeObject();
+        store().free(item);
+    }
+};
+
+static_assert(std::is_trivially_destructible<ForeignLargeObject>::value,
+    "BoostObjectPool relies on the dtor of its items being trivial");
+
+// boost::pool<>: just raw memory chunks, so the ctor and the dtor must be run explicitly
+class BoostPool : public ForeignPool {
+public:
+    BoostPool(size_t init_size, size_t enlarge_size)
+        : m_pool(sizeof(ForeignLargeObject), init_size)
+    {
+        (void)enlarge_size; // each new chunk is twice as large as the previous one
+    }
+
+    HForeignLargeObject allocate_through_init()
+    {
+        ForeignLargeObject* item = new (m_pool.malloc()) ForeignLargeObject();
+        item->init();
+        item->m_pool = this;
+        return HForeignLargeObject(item);
+    }
+    virtual void release(ForeignLargeObject* item) override
+    {
+        item->~ForeignLargeObject();
+        m_pool.free(item);
+    }
+
+private:
+    boost::pool<> m_pool;
+};
+
+#if BENCH_HAS_PMR
+// std::pmr::unsynchronized_pool_resource: std::allocate_shared<> puts the item and the control block of the
+// std::shared_ptr<> in the same chunk of the pool
+class PmrPool {
+public:
+    PmrPool(size_t init_size, size_t enlarge_size)
+        : m_resource(std::pmr::pool_options { enlarge_size, sizeof(ForeignLargeObject) + 64 })
+    {
+        (void)init_size; // memory is obtained only when the first item gets allocated
+    }
+
+    SForeignLargeObject allocate_through_init()
+    {
+        SForeignLargeObject item = std::allocate_shared<ForeignLargeObject>(
+            std::pmr::polymorphic_allocator<ForeignLargeObject>(&m_resource));
+        item->init();
+        return item;
+    }
+
+private:
+    std::pmr::unsynchronized_pool_resource m_resource;
+};
+#endif
+
+// The usual recycling pool built on std::shared_ptr<> (like e.g. steinwurf/recycle): the free items are kept alive by
+// the pool, and each allocated item is handed out through a new std::shared_ptr<> whose deleter puts it back into the
+// pool; its control block still needs a malloc for each allocation.
+// NOTE: the deleter refers to the pool, so the items must not outlive it, as it happens in this benchmark
+class SharedPtrRecyclePool {
+public:
+    SharedPtrRecyclePool(size_t init_size, size_t enlarge_size)
+    {
+        (void)enlarge_size; // items are created one at a time, when there is no free item
+        m_free_items.reserve(init_size);
+    }
+
+    SForeignLargeObject allocate_through_init()
+    {
+        SForeignLargeObject item;
+        if (m_free_items.empty())
+            item = std::make_shared<ForeignLargeObject>();
+        else {
+            item = std::move(m_free_items.back());
+            m_free_items.pop_back();
+        }
+        item->init();
+
+        ForeignLargeObject* pitem = item.get();
+        return SForeignLargeObject(
+            pitem, [this, item](ForeignLargeObject*) mutable { m_free_items.push_back(std::move(item)); });
+    }
+
+private:
+    std::vector<SForeignLargeObject> m_free_items;
+};
+
+//------------------------------------------------------------------------------
+// Latency histograms
+//------------------------------------------------------------------------------
+
+// A histogram of latencies in the style of HdrHistogram: values below 32nsec get a bucket each, while larger values
+// fall into 16 buckets for each power of 2, so that every value is recorded with a relative error below 1/16 using a
+// fixed amount of memory and just a few instructions.
+class latency_histogram {
+public:
+    latency_histogram() { reset(); }
+
+    void reset()
+    {
+        memset(m_counts, 0, sizeof(m_counts));
+        m_total_count = 0;
+        m_max = 0;
+    }
+
+    void record(timing_t value)
+    {
+        m_counts[bucket_of(value)]++;
+        m_total_count++;
+        m_max = std::max(m_max, value);
+    }
+
+    size_t total_count() const { return m_total_count; }
+    timing_t max() const { return m_max; }
+
+    // returns the value which is not exceeded by the given fraction (0-1) of the recorded values
+    timing_t value_at_fraction(double fraction) const
+    {
+        size_t count = 0, threshold = std::max((size_t)std::ceil(fraction * m_total_count), (size_t)1);
+        for (size_t i = 0; i < NUM_BUCKETS; i++) {
+            count += m_counts[i];
+            if (count >= threshold)
+                return std::min(highest_value_of(i), m_max);
+        }
+        return m_max;
+    }
+
+    // writes the tail percentiles and the cumulative distribution (one point per non-empty bucket) of the values
+    void to_json(json_ctx_t* json_ctx, const char* name) const
+    {
+        json_attr_object_begin(json_ctx, name);
+        json_attr_double(json_ctx, "count", m_total_count);
+        json_attr_double(json_ctx, "p50", value_at_fraction(0.5));
+        json_attr_double(json_ctx, "p99", value_at_fraction(0.99));
+        json_attr_double(json_ctx, "p99.9", value_at_fraction(0.999));
+        json_attr_double(json_ctx, "max", m_max);
+
+        json_array_begin(json_ctx, "cdf_nsec");
+        for (size_t i = 0; i < NUM_BUCKETS; i++)
+            if (m_counts[i])
+                json_element_double(json_ctx, std::min(highest_value_of(i), m_max));
+        json_array_end(json_ctx);
+
+        size_t count = 0;
+        json_array_begin(json_ctx, "cdf_fraction");
+        for (size_t i = 0; i < NUM_BUCKETS; i++) {
+            if (m_counts[i]) {
+                count += m_counts[i];
+                json_element_double(json_ctx, (double)count / (double)m_total_count);
+            }
+        }
+        json_array_end(json_ctx);
+        json_attr_object_end(json_ctx);
+    }
+
+private:
+    enum {
+        SUB_BUCKET_BITS = 4,
+        SUB_BUCKETS = 1 << SUB_BUCKET_BITS,
+        NUM_BUCKETS = (64 - SUB_BUCKET_BITS + 1) * SUB_BUCKETS,
+    };
+
+    static size_t bucket_of(timing_t value)
+    {
+        if (value < 2 * SUB_BUCKETS)
+            return (size_t)value;
+        unsigned int shift = 63 - __builtin_clzll(value) - SUB_BUCKET_BITS;
+        return shift * SUB_BUCKETS + (size_t)(value >> shift); // value >> shift is in [SUB_BUCKETS, 2*SUB_BUCKETS)
+    }
+
+    static timing_t highest_value_of(size_t bucket)
+    {
+        if (bucket < 2 * SUB_BUCKETS)
+            return bucket;
+        unsigned int shift = bucket / SUB_BUCKETS - 1;
+        timing_t top = bucket % SUB_BUCKETS + SUB_BUCKETS;
+        return ((top + 1) << shift) - 1;
+    }
+
+    size_t m_counts[NUM_BUCKETS];
+    size_t m_total_count;
+    timing_t m_max;
+};
+
 //------------------------------------------------------------------------------
 // Benchmarks
 //------------------------------------------------------------------------------
 
+// Allocates an item from the given pool, recording the latency of the allocation if a histogram is given
+template <class PoolUnderTest>
+static auto timed_allocate(PoolUnderTest& pool, latency_histogram* latency) -> decltype(pool.allocate_through_init())
+{
+    if (!latency)
+        return pool.allocate_through_init();
+
+    timing_t start, stop;
+    TIMING_NOW_WALLCLOCK(start);
+    auto item = pool.allocate_through_init();
+    TIMING_NOW_WALLCLOCK(stop);
+    latency->record(stop - start);
+    return item;
+}
+
+// Releases the given item, recording the latency of the release if a histogram is given
+template <class PoolUnderTest, class ItemPtr>
+static void timed_release(PoolUnderTest& pool, ItemPtr& item, latency_histogram* latency)
+{
+    if (!latency) {
+        release_item(pool, item);
+        return;
+    }
+
+    timing_t start, stop;
+    TIMING_NOW_WALLCLOCK(start);
+    release_item(pool, item);
+    TIMING_NOW_WALLCLOCK(stop);
+    latency->record(stop - start);
+}
+
 template <class PoolUnderTest>
-static void main_benchmark_loop(
-    PoolUnderTest& pool, BenchPattern_t pattern, size_t num_elements, size_t& num_freed, size_t& max_active)
+static void main_benchmark_loop(PoolUnderTest& pool, BenchPattern_t pattern, size_t num_elements, size_t& num_freed,
+    size_t& max_active, latency_histogram* alloc_latency = nullptr, latency_histogram* release_latency = nullptr)
 {
+    typedef decltype(pool.allocate_through_init()) item_ptr; // the memory pools of other libraries have other types
+
     num_freed = 0, max_active = 0;
 
     switch (pattern) {
     case BENCH_PATTERN_CONTINUOUS_ALLOCATION: {
-        std::vector<HLargeObject> helper_container;
+        std::vector<item_ptr> helper_container;
         helper_container.reserve(num_elements); // this results in a single malloc that will not alter the benchmark!
         for (unsigned int i = 0; i < num_elements; i++) {
-            HLargeObject myLargeObject = pool.allocate_through_init();
+            item_ptr myLargeObject = timed_allocate(pool, alloc_latency);
             assert(myLargeObject);
 
             // simulate a very light processing of the allocated item:
@@ -121,15 +504,17 @@ static void main_benchmark_loop(
             max_active = std::max(max_active, helper_container.size());
         }
 
+        for (auto& item : helper_container)
+            timed_release(pool, item, release_latency);
         helper_container.clear();
     } break;
 
     case BENCH_PATTERN_MIXED_ALLOC_FREE: {
-        std::unordered_map<int, HLargeObject> helper_container;
+        std::unordered_map<int, item_ptr> helper_container;
         helper_container.reserve(num_elements / 10);
 
         for (unsigned int i = 0; i < num_elements; i++) {
-            HLargeObject myLargeObject = pool.allocate_through_init();
+            item_ptr myLargeObject = timed_allocate(pool, alloc_latency);
             assert(myLargeObject);
 
             // simulate a very light processing of the allocated item:
@@ -138,7 +523,7 @@ static void main_benchmark_loop(
 
             if ((i % 33) == 0) {
                 // we suddenly realize that we don't really need the just-allocated item... release it immediately
-                // (it's enough to simply _not_ store it)
+                timed_release(pool, myLargeObject, release_latency);
             } else {
                 helper_container[i] = myLargeObject;
 
@@ -148,8 +533,10 @@ static void main_benchmark_loop(
 
                     auto it = helper_container.find(value_to_release);
                     if (it != helper_container.end()) {
-                        // erasing the smart pointer from the std::map will trigger its return to the memory pool:
+                        // releasing the last reference to the item will trigger its return to the memory pool:
+                        item_ptr item = std::move(it->second);
                         helper_container.erase(value_to_release);
+                        timed_release(pool, item, release_latency);
                         num_freed++;
                     }
                 }
@@ -161,6 +548,53 @@ static void main_benchmark_loop(
     }
 }
 
+// Runs the given allocation pattern on the memory pool of another library, through an adapter exposing
+// allocate_through_init() like boost_intrusive_pool does, and writes its results next to the ones of
+// boost_intrusive_pool and plain malloc.
+template <class PoolUnderTest>
+static void do_comparison_benchmark(json_ctx_t* json_ctx, const char* name, BenchPattern_t pattern,
+    size_t initial_size, size_t enlarge_step, size_t num_items)
+{
+    size_t num_freed, max_active;
+    struct rusage usage;
+    timing_t avg_time;
+    latency_histogram alloc_latency, release_latency;
+
+    {
+        PoolUnderTest pool(initial_size, enlarge_step);
+
+        timing_t start, stop, elapsed, accumulated = 0;
+        for (int k = 0; k < NUM_AVERAGING_RUNS; k++) {
+            TIMING_NOW(start);
+            main_benchmark_loop(pool, pattern, num_items, num_freed, max_active);
+            TIMING_NOW(stop);
+            TIMING_DIFF(elapsed, start, stop);
+            TIMING_ACCUM(accumulated, elapsed);
+        }
+
+        avg_time = accumulated / NUM_AVERAGING_RUNS;
+        getrusage(RUSAGE_SELF, &usage);
+    }
+    {
+        PoolUnderTest latency_pool(initial_size, enlarge_step);
+        size_t unused_freed, unused_active;
+        main_benchmark_loop(
+            latency_pool, pattern, num_items, unused_freed, unused_active, &alloc_latency, &release_latency);
+    }
+
+    if (json_ctx) {
+        json_attr_object_begin(json_ctx, name);
+        json_attr_double(json_ctx, "duration_nsec", avg_time);
+        json_attr_double(json_ctx, "duration_nsec_per_item", (double)avg_time / (double)num_items);
+        json_attr_double(json_ctx, "num_items_freed", num_freed);
+        json_attr_double(json_ctx, "max_active_items", max_active);
+        json_attr_double(json_ctx, "max_rss", usage.ru_maxrss);
+        alloc_latency.to_json(json_ctx, "allocate_latency_nsec");
+        release_latency.to_json(json_ctx, "release_latency_nsec");
+        json_attr_object_end(json_ctx);
+    }
+}
+
 static void do_benchmark(json_ctx_t* json_ctx)
 {
     typedef struct {
@@ -228,6 +662,7 @@ static void do_benchmark(json_ctx_t* json_ctx)
             size_t num_freed[2], max_active[2], ctor_count[2], dtor_count[2], num_resizings;
             struct rusage usage[2];
             timing_t avg_time[2];
+            latency_histogram alloc_latency[2], release_latency[2];
 
             // run the benchmark with boost_intrusive_pool
             {
@@ -254,6 +689,15 @@ static void do_benchmark(json_ctx_t* json_ctx)
                 getrusage(RUSAGE_SELF, &usage[0]);
             }
 
+            // measure the latency of each allocation and release on a new memory pool, so that the spikes caused by
+            // its enlarge steps show up in the tail of the histograms
+            {
+                boost_intrusive_pool<LargeObject> latency_pool(runConfig.initial_size, runConfig.enlarge_step);
+                size_t unused_freed, unused_active;
+                main_benchmark_loop(latency_pool, testPatterns[j].pattern, runConfig.num_items, unused_freed,
+                    unused_active, &alloc_latency[0], &release_latency[0]);
+            }
+
             // run the benchmark with NoPool
             {
                 LargeObject::reset_counts();
@@ -275,6 +719,10 @@ static void do_benchmark(json_ctx_t* json_ctx)
                 dtor_count[1] = LargeObject::m_dtor_count;
 
                 getrusage(RUSAGE_SELF, &usage[1]);
+
+                size_t unused_freed, unused_active;
+                main_benchmark_loop(comparison_pool, testPatterns[j].pattern, runConfig.num_items, unused_freed,
+                    unused_active, &alloc_latency[1], &release_latency[1]);
             }
 
             // output results as JSON:
@@ -296,6 +744,8 @@ static void do_benchmark(json_ctx_t* json_ctx)
                 json_attr_double(json_ctx, "ctor_count", ctor_count[0]);
                 json_attr_double(json_ctx, "dtor_count", dtor_count[0]);
                 json_attr_double(json_ctx, "num_resizings", num_resizings);
+                alloc_latency[0].to_json(json_ctx, "allocate_latency_nsec");
+                release_latency[0].to_json(json_ctx, "release_latency_nsec");
                 json_attr_object_end(json_ctx); // boost_intrusive_pool_item
 
                 // test results
@@ -307,9 +757,26 @@ static void do_benchmark(json_ctx_t* json_ctx)
                 json_attr_double(json_ctx, "max_rss", usage[1].ru_maxrss);
                 json_attr_double(json_ctx, "ctor_count", ctor_count[1]);
                 json_attr_double(json_ctx, "dtor_count", dtor_count[1]);
+                alloc_latency[1].to_json(json_ctx, "allocate_latency_nsec");
+                release_latency[1].to_json(json_ctx, "release_latency_nsec");
                 json_attr_object_end(json_ctx); // plain_malloc
-                json_attr_object_end(json_ctx); // run
             }
+
+            // run the same benchmark with the memory pools of other libraries
+            const BenchPattern_t pattern = testPatterns[j].pattern;
+            do_comparison_benchmark<BoostObjectPool>(json_ctx, "boost_object_pool", pattern, runConfig.initial_size,
+                runConfig.enlarge_step, runConfig.num_items);
+            do_comparison_benchmark<BoostPool>(
+                json_ctx, "boost_pool", pattern, runConfig.initial_size, runConfig.enlarge_step, runConfig.num_items);
+#if BENCH_HAS_PMR
+            do_comparison_benchmark<PmrPool>(json_ctx, "pmr_unsynchronized_pool_resource", pattern,
+                runConfig.initial_size, runConfig.enlarge_step, runConfig.num_items);
+#endif
+            do_comparison_benchmark<SharedPtrRecyclePool>(json_ctx, "shared_ptr_recycle_pool", pattern,
+                runConfig.initial_size, runConfig.enlarge_step, runConfig.num_items);
+
+            if (json_ctx)
+                json_attr_object_end(json_ctx); // run
         }
 
         if (json_ctx)
@@ -317,13 +784,556 @@ static void do_benchmark(json_ctx_t* json_ctx)
     }
 }
 
-static void do_json_benchmark()
+template <class PoolUnderTest> static void contention_benchmark_thread(PoolUnderTest& pool, size_t num_items)
+{
+    // each thread keeps alive a small window of items and releases them in FIFO order:
+    HLargeObject window[CONTENTION_WINDOW];
+    for (size_t i = 0; i < num_items; i++) {
+        HLargeObject& slot = window[i % CONTENTION_WINDOW];
+        release_item(pool, slot);
+
+        slot = pool.allocate_through_init();
+        assert(slot);
+
+        // simulate a very light processing of the allocated item:
+        slot->write(10, slot->read(10) + 2);
+    }
+
+    for (unsigned int i = 0; i < CONTENTION_WINDOW; i++)
+        release_item(pool, window[i]);
+}
+
+template <class PoolUnderTest>
+static timing_t run_contention_benchmark(PoolUnderTest& pool, unsigned int num_threads, size_t num_items_per_thread)
+{
+    timing_t start, stop, elapsed;
+    std::vector<std::thread> threads;
+
+    TIMING_NOW_WALLCLOCK(start);
+    for (unsigned int t = 0; t < num_threads; t++)
+        threads.emplace_back(contention_benchmark_thread<PoolUnderTest>, std::ref(pool), num_items_per_thread);
+    for (auto& th : threads)
+        th.join();
+    TIMING_NOW_WALLCLOCK(stop);
+
+    TIMING_DIFF(elapsed, start, stop);
+    return elapsed;
+}
+
+static void json_contention_results(json_ctx_t* json_ctx, const char* name, timing_t avg_time, size_t num_items)
+{
+    json_attr_object_begin(json_ctx, name);
+    json_attr_double(json_ctx, "duration_nsec", avg_time);
+    json_attr_double(json_ctx, "duration_nsec_per_item", (double)avg_time / (double)num_items);
+    json_attr_double(json_ctx, "items_per_sec", (double)num_items * 1e9 / (double)avg_time);
+    json_attr_object_end(json_ctx);
+}
+
+// All threads allocate from and release to the same memory pool, at the highest possible rate.
+static void do_contention_benchmark(json_ctx_t* json_ctx, unsigned int num_threads)
+{
+    const size_t num_items_per_thread = CONTENTION_NUM_ITEMS_PER_THREAD;
+    const size_t pool_size = num_threads * CONTENTION_WINDOW;
+    timing_t avg_time[4], accumulated;
+
+    // run the benchmark with concurrent_boost_intrusive_pool
+    {
+        concurrent_boost_intrusive_pool<LargeObject> pool(pool_size, CONTENTION_WINDOW);
+        accumulated = 0;
+        for (int k = 0; k < NUM_AVERAGING_RUNS; k++)
+            accumulated += run_contention_benchmark(pool, num_threads, num_items_per_thread);
+        avg_time[0] = accumulated / NUM_AVERAGING_RUNS;
+    }
+
+    // run the benchmark with concurrent_boost_intrusive_pool and per-thread magazines
+    {
+        concurrent_boost_intrusive_pool<LargeObject> pool(pool_size, CONTENTION_WINDOW);
+        pool.set_magazine_size(CONTENTION_MAGAZINE_SIZE);
+        accumulated = 0;
+        for (int k = 0; k < NUM_AVERAGING_RUNS; k++)
+            accumulated += run_contention_benchmark(pool, num_threads, num_items_per_thread);
+        avg_time[3] = accumulated / NUM_AVERAGING_RUNS;
+    }
+
+    // run the benchmark with a boost_intrusive_pool protected by a mutex
+    {
+        MutexPool pool(pool_size, CONTENTION_WINDOW);
+        accumulated = 0;
+        for (int k = 0; k < NUM_AVERAGING_RUNS; k++)
+            accumulated += run_contention_benchmark(pool, num_threads, num_items_per_thread);
+        avg_time[1] = accumulated / NUM_AVERAGING_RUNS;
+    }
+
+    // run the benchmark with NoPool
+    {
+        NoPool pool;
+        accumulated = 0;
+        for (int k = 0; k < NUM_AVERAGING_RUNS; k++)
+            accumulated += run_contention_benchmark(pool, num_threads, num_items_per_thread);
+        avg_time[2] = accumulated / NUM_AVERAGING_RUNS;
+    }
+
+    // output results as JSON:
+    if (json_ctx) {
+        size_t num_items = num_threads * num_items_per_thread;
+
+        json_attr_object_begin(json_ctx, "contention");
+        json_attr_string(json_ctx, "desc", "All threads allocating and releasing items of a shared pool");
+
+        // test setup
+        json_attr_double(json_ctx, "num_threads", num_threads);
+        json_attr_double(json_ctx, "num_items", num_items);
+
+        // test results
+        json_contention_results(json_ctx, "concurrent_boost_intrusive_pool", avg_time[0], num_items);
+        json_contention_results(json_ctx, "concurrent_boost_intrusive_pool_magazines", avg_time[3], num_items);
+        json_contention_results(json_ctx, "mutex_boost_intrusive_pool", avg_time[1], num_items);
+        json_contention_results(json_ctx, "plain_malloc", avg_time[2], num_items);
+        json_attr_object_end(json_ctx); // contention
+    }
+}
+
+template <class PoolUnderTest>
+static timing_t run_scaling_benchmark(PoolUnderTest& pool, unsigned int num_threads, size_t num_items_per_thread)
+{
+    timing_t accumulated = 0;
+    for (int k = 0; k < SCALING_NUM_AVERAGING_RUNS; k++)
+        accumulated += run_contention_benchmark(pool, num_threads, num_items_per_thread);
+    return accumulated / SCALING_NUM_AVERAGING_RUNS;
+}
+
+// Runs the contention benchmark with an increasing number of threads, to show how the throughput of each
+// thread-safe memory pool scales with the number of cores.
+static void do_scaling_benchmark(json_ctx_t* json_ctx, unsigned int max_threads)
+{
+    const size_t num_items_per_thread = CONTENTION_NUM_ITEMS_PER_THREAD;
+
+    json_attr_object_begin(json_ctx, "scaling");
+    json_attr_string(json_ctx, "desc", "All threads allocating and releasing items of a shared pool");
+    json_attr_double(json_ctx, "max_threads", max_threads);
+    json_array_begin(json_ctx, "runs");
+
+    for (unsigned int num_threads = 1; num_threads <= max_threads; num_threads++) {
+        const size_t pool_size = num_threads * CONTENTION_WINDOW;
+        const size_t num_items = num_threads * num_items_per_thread;
+        timing_t avg_time[3];
+
+        {
+            concurrent_boost_intrusive_pool<LargeObject> pool(pool_size, CONTENTION_WINDOW);
+            avg_time[0] = run_scaling_benchmark(pool, num_threads, num_items_per_thread);
+        }
+        {
+            concurrent_boost_intrusive_pool<LargeObject> pool(pool_size, CONTENTION_WINDOW);
+            pool.set_magazine_size(CONTENTION_MAGAZINE_SIZE);
+            avg_time[1] = run_scaling_benchmark(pool, num_threads, num_items_per_thread);
+        }
+        {
+            sharded_boost_intrusive_pool<LargeObject> pool(pool_size, CONTENTION_WINDOW);
+            avg_time[2] = run_scaling_benchmark(pool, num_threads, num_items_per_thread);
+        }
+
+        json_element_object_begin(json_ctx);
+        json_attr_double(json_ctx, "num_threads", num_threads);
+        json_attr_double(json_ctx, "num_items", num_items);
+        json_contention_results(json_ctx, "concurrent_boost_intrusive_pool", avg_time[0], num_items);
+        json_contention_results(json_ctx, "concurrent_boost_intrusive_pool_magazines", avg_time[1], num_items);
+        json_contention_results(json_ctx, "sharded_boost_intrusive_pool", avg_time[2], num_items);
+        json_element_object_end(json_ctx);
+    }
+
+    json_array_end(json_ctx); // runs
+    json_attr_object_end(json_ctx); // scaling
+}
+
+// Runs main_benchmark_loop() on the given memory pool and stores the wall-clock time it took on this thread.
+// A first untimed run warms up the memory pool, so that all pools get measured after their arenas have been
+// allocated and touched, no matter if they are private to this thread or shared with other threads.
+template <class PoolUnderTest>
+static void multithread_benchmark_thread(
+    PoolUnderTest& pool, BenchPattern_t pattern, size_t num_items, timing_t& elapsed)
+{
+    size_t num_freed, max_active;
+    timing_t start, stop;
+
+    main_benchmark_loop(pool, pattern, num_items, num_freed, max_active);
+
+    TIMING_NOW_WALLCLOCK(start);
+    main_benchmark_loop(pool, pattern, num_items, num_freed, max_active);
+    TIMING_NOW_WALLCLOCK(stop);
+
+    TIMING_DIFF(elapsed, start, stop);
+}
+
+// Runs the given thread function on num_threads threads, SCALING_NUM_AVERAGING_RUNS times: returns the average
+// wall-clock time of a run and stores the average time taken by each thread.
+template <class ThreadFunction>
+static timing_t run_multithread_benchmark(
+    ThreadFunction thread_fn, unsigned int num_threads, std::vector<timing_t>& thread_time)
+{
+    timing_t accumulated = 0;
+    thread_time.assign(num_threads, 0);
+
+    for (int k = 0; k < SCALING_NUM_AVERAGING_RUNS; k++) {
+        std::vector<timing_t> elapsed(num_threads);
+        std::vector<std::thread> threads;
+        timing_t start, stop;
+
+        TIMING_NOW_WALLCLOCK(start);
+        for (unsigned int t = 0; t < num_threads; t++)
+            threads.emplace_back(thread_fn, std::ref(elapsed[t]));
+        for (auto& th : threads)
+            th.join();
+        TIMING_NOW_WALLCLOCK(stop);
+
+        accumulated += stop - start;
+        for (unsigned int t = 0; t < num_threads; t++)
+            thread_time[t] += elapsed[t];
+    }
+
+    for (auto& t : thread_time)
+        t /= SCALING_NUM_AVERAGING_RUNS;
+    return accumulated / SCALING_NUM_AVERAGING_RUNS;
+}
+
+// Writes the overall throughput of a multithreaded run together with the throughput of each thread; the scaling
+// efficiency is the overall throughput divided by num_threads times the throughput measured with a single thread.
+static double json_multithread_results(json_ctx_t* json_ctx, const char* name, timing_t avg_time,
+    const std::vector<timing_t>& thread_time, size_t num_items_per_thread, double single_thread_items_per_sec)
+{
+    const size_t num_items = thread_time.size() * num_items_per_thread;
+    const double items_per_sec = (double)num_items * 1e9 / (double)avg_time;
+    if (single_thread_items_per_sec == 0)
+        single_thread_items_per_sec = items_per_sec;
+
+    json_attr_object_begin(json_ctx, name);
+    json_attr_double(json_ctx, "duration_nsec", avg_time);
+    json_attr_double(json_ctx, "duration_nsec_per_item", (double)avg_time / (double)num_items);
+    json_attr_double(json_ctx, "items_per_sec", items_per_sec);
+    json_attr_double(
+        json_ctx, "scaling_efficiency", items_per_sec / (thread_time.size() * single_thread_items_per_sec));
+    json_array_begin(json_ctx, "thread_items_per_sec");
+    for (timing_t t : thread_time)
+        json_element_double(json_ctx, (double)num_items_per_thread * 1e9 / (double)t);
+    json_array_end(json_ctx);
+    json_attr_object_end(json_ctx);
+
+    return single_thread_items_per_sec;
+}
+
+// Runs the allocation patterns of the main benchmark on 1..N threads at the same time, each thread allocating from a
+// boost_intrusive_pool of its own, from a memory pool shared by all threads or through plain malloc, to show where
+// each of them stops scaling. Run it with LD_PRELOAD to compare the malloc implementations.
+static void do_multithread_benchmark(json_ctx_t* json_ctx, unsigned int max_threads)
+{
+    typedef struct {
+        BenchPattern_t pattern;
+        unsigned int initial_size;
+        unsigned int enlarge_step;
+    } multithread_config_t;
+
+    const multithread_config_t configs[] = {
+        { BENCH_PATTERN_CONTINUOUS_ALLOCATION, 1024, 1024 },
+        { BENCH_PATTERN_MIXED_ALLOC_FREE, 1024, 128 },
+    };
+    const size_t num_items_per_thread = MULTITHREAD_NUM_ITEMS_PER_THREAD;
+
+    json_attr_object_begin(json_ctx, "multithread");
+    json_attr_string(json_ctx, "desc", "Allocation patterns of the main benchmark running on several threads");
+    json_attr_double(json_ctx, "max_threads", max_threads);
+    json_attr_double(json_ctx, "num_items_per_thread", num_items_per_thread);
+
+    for (size_t j = 0; j < sizeof(configs) / sizeof(configs[0]); j++) {
+        const multithread_config_t& config = configs[j];
+        double single_thread_items_per_sec[4] = { 0, 0, 0, 0 };
+
+        json_attr_object_begin(json_ctx, (std::string("pattern_") + std::to_string(j + 1)).c_str());
+        json_attr_string(json_ctx, "desc", BenchPattern2String(config.pattern).c_str());
+        json_attr_double(json_ctx, "initial_size", config.initial_size);
+        json_attr_double(json_ctx, "enlarge_step", config.enlarge_step);
+        json_array_begin(json_ctx, "runs");
+
+        for (unsigned int num_threads = 1; num_threads <= max_threads; num_threads++) {
+            std::vector<timing_t> thread_time[4];
+            timing_t avg_time[4];
+
+            // each thread allocates from a boost_intrusive_pool of its own
+            avg_time[0] = run_multithread_benchmark(
+                [&config, num_items_per_thread](timing_t& elapsed) {
+                    boost_intrusive_pool<LargeObject> pool(config.initial_size, config.enlarge_step);
+                    multithread_benchmark_thread(pool, config.pattern, num_items_per_thread, elapsed);
+                },
+                num_threads, thread_time[0]);
+
+            // all threads allocate from the same memory pool
+            {
+                concurrent_boost_intrusive_pool<LargeObject> pool(
+                    num_threads * config.initial_size, config.enlarge_step);
+                pool.set_magazine_size(CONTENTION_MAGAZINE_SIZE);
+                avg_time[1] = run_multithread_benchmark(
+                    [&pool, &config, num_items_per_thread](timing_t& elapsed) {
+                        multithread_benchmark_thread(pool, config.pattern, num_items_per_thread, elapsed);
+                    },
+                    num_threads, thread_time[1]);
+            }
+            {
+                sharded_boost_intrusive_pool<LargeObject> pool(num_threads * config.initial_size, config.enlarge_step);
+                avg_time[2] = run_multithread_benchmark(
+                    [&pool, &config, num_items_per_thread](timing_t& elapsed) {
+                        multithread_benchmark_thread(pool, config.pattern, num_items_per_thread, elapsed);
+                    },
+                    num_threads, thread_time[2]);
+            }
+
+            // all threads go through malloc
+            avg_time[3] = run_multithread_benchmark(
+                [&config, num_items_per_thread](timing_t& elapsed) {
+                    NoPool pool;
+                    multithread_benchmark_thread(pool, config.pattern, num_items_per_thread, elapsed);
+                },
+                num_threads, thread_time[3]);
+
+            const char* names[] = { "boost_intrusive_pool_per_thread", "concurrent_boost_intrusive_pool_magazines",
+                "sharded_boost_intrusive_pool", "plain_malloc" };
+            json_element_object_begin(json_ctx);
+            json_attr_double(json_ctx, "num_threads", num_threads);
+            json_attr_double(json_ctx, "num_items", num_threads * num_items_per_thread);
+            for (int i = 0; i < 4; i++)
+                single_thread_items_per_sec[i] = json_multithread_results(json_ctx, names[i], avg_time[i],
+                    thread_time[i], num_items_per_thread, single_thread_items_per_sec[i]);
+            json_element_object_end(json_ctx);
+        }
+
+        json_array_end(json_ctx); // runs
+        json_attr_object_end(json_ctx); // pattern
+    }
+
+    json_attr_object_end(json_ctx); // multithread
+}
+
+// Compares the time needed to release a batch of items one by one against the time needed to release the same
+// batch through boost_intrusive_pool::release_bulk().
+static void do_bulk_benchmark(json_ctx_t* json_ctx)
+{
+    const size_t batch_sizes[] = { 8, 32, 256 };
+
+    json_attr_object_begin(json_ctx, "release_bulk");
+    json_attr_string(json_ctx, "desc", "Release of batches of items allocated through allocate_bulk()");
+    json_array_begin(json_ctx, "runs");
+
+    for (size_t batch_size : batch_sizes) {
+        const size_t num_batches = BULK_NUM_ITEMS / batch_size;
+        timing_t avg_time[2];
+
+        for (int method = 0; method < 2; method++) {
+            boost_intrusive_pool<LargeObject> pool(
+                batch_size, batch_size, BOOST_INTRUSIVE_POOL_NO_MAX_SIZE, RECYCLE_METHOD_DESTROY_FUNCTION);
+            std::vector<HLargeObject> batch;
+            batch.reserve(batch_size);
+
+            timing_t accumulated = 0;
+            for (int k = 0; k < NUM_AVERAGING_RUNS; k++) {
+                for (size_t i = 0; i < num_batches; i++) {
+                    timing_t start, stop, elapsed;
+
+                    batch.clear();
+                    pool.allocate_bulk(batch_size, std::back_inserter(batch));
+
+                    TIMING_NOW(start);
+                    if (method == 0) {
+                        for (auto& item : batch)
+                            item = nullptr;
+                    } else {
+                        pool.release_bulk(batch);
+                    }
+                    TIMING_NOW(stop);
+
+                    TIMING_DIFF(elapsed, start, stop);
+                    TIMING_ACCUM(accumulated, elapsed);
+                }
+            }
+            avg_time[method] = accumulated / NUM_AVERAGING_RUNS;
+        }
+
+        json_element_object_begin(json_ctx);
+        json_attr_double(json_ctx, "batch_size", batch_size);
+        json_attr_double(json_ctx, "num_items", num_batches * batch_size);
+        json_contention_results(json_ctx, "release_one_by_one", avg_time[0], num_batches * batch_size);
+        json_contention_results(json_ctx, "release_bulk", avg_time[1], num_batches * batch_size);
+        json_element_object_end(json_ctx);
+    }
+
+    json_array_end(json_ctx); // runs
+    json_attr_object_end(json_ctx); // release_bulk
+}
+
+// Measures the allocation/release throughput for items having a 3-level class hierarchy, together with the cost of
+// the two downcasts (one in allocate, one in recycle) done for each item by the memory pool, implemented through
+// dynamic_cast<> (as done by older releases) and through static_cast<> (as done now).
+static void do_inheritance_benchmark(json_ctx_t* json_ctx)
+{
+    const size_t num_items = INHERITANCE_NUM_ITEMS;
+    timing_t avg_time[3];
+
+    boost_intrusive_pool<DeepObject> pool(CONTENTION_WINDOW, CONTENTION_WINDOW);
+
+    // allocate & release the items of the pool
+    {
+        timing_t start, stop, elapsed, accumulated = 0;
+        for (int k = 0; k < NUM_AVERAGING_RUNS; k++) {
+            HDeepObject window[CONTENTION_WINDOW];
+            TIMING_NOW(start);
+            for (size_t i = 0; i < num_items; i++) {
+                HDeepObject& slot = window[i % CONTENTION_WINDOW];
+                slot = pool.allocate_through_init();
+            }
+            TIMING_NOW(stop);
+            TIMING_DIFF(elapsed, start, stop);
+            TIMING_ACCUM(accumulated, elapsed);
+        }
+        avg_time[0] = accumulated / NUM_AVERAGING_RUNS;
+    }
+
+    // downcast the items of the pool like the memory pool does
+    HDeepObject window[CONTENTION_WINDOW];
+    memorypool::boost_intrusive_pool_item* base_items[CONTENTION_WINDOW];
+    for (unsigned int i = 0; i < CONTENTION_WINDOW; i++) {
+        window[i] = pool.allocate_through_init();
+        base_items[i] = window[i].get();
+    }
+    for (int method = 0; method < 2; method++) {
+        timing_t start, stop, elapsed, accumulated = 0;
+        for (int k = 0; k < NUM_AVERAGING_RUNS; k++) {
+            int sum = 0;
+            TIMING_NOW(start);
+            for (size_t i = 0; i < num_items; i++) {
+                memorypool::boost_intrusive_pool_item* volatile pitem = base_items[i % CONTENTION_WINDOW];
+                for (int j = 0; j < 2; j++) {
+                    DeepObject* pderived
+                        = (method == 0) ? dynamic_cast<DeepObject*>(pitem) : static_cast<DeepObject*>(pitem);
+                    sum += (pderived != nullptr);
+                }
+            }
+            TIMING_NOW(stop);
+            assert(sum == (int)(2 * num_items));
+            TIMING_DIFF(elapsed, start, stop);
+            TIMING_ACCUM(accumulated, elapsed);
+        }
+        avg_time[1 + method] = accumulated / NUM_AVERAGING_RUNS;
+    }
+
+    json_attr_object_begin(json_ctx, "inheritance");
+    json_attr_string(json_ctx, "desc", "Allocation/release of items having a 3-level class hierarchy");
+    json_attr_double(json_ctx, "num_items", num_items);
+    json_contention_results(json_ctx, "boost_intrusive_pool", avg_time[0], num_items);
+    json_contention_results(json_ctx, "downcasts_through_dynamic_cast", avg_time[1], num_items);
+    json_contention_results(json_ctx, "downcasts_through_static_cast", avg_time[2], num_items);
+    json_attr_object_end(json_ctx); // inheritance
+}
+
+// Measures the time needed to process the items of a large memory pool in random order, when the arenas are allocated
+// from the heap and when they are allocated from huge pages: with 1KB items, almost each access touches a different
+// 4KB page, so the number of TLB misses grows with the number of items unless huge pages are used.
+static void do_hugepages_benchmark(json_ctx_t* json_ctx)
+{
+    const size_t num_items = HUGEPAGES_NUM_ITEMS;
+    const size_t num_accesses = HUGEPAGES_NUM_ACCESSES;
+    const memory_backing_e backings[] = { MEMORY_BACKING_DEFAULT, MEMORY_BACKING_HUGE_PAGES };
+    const char* names[] = { "default_memory_backing", "huge_pages_memory_backing" };
+
+    // the same random access pattern is used for both memory backings
+    std::vector<size_t> order(num_items);
+    for (size_t i = 0; i < num_items; i++)
+        order[i] = i;
+    std::shuffle(order.begin(), order.end(), std::mt19937(1234));
+
+    json_attr_object_begin(json_ctx, "hugepages");
+    json_attr_string(json_ctx, "desc", "Random-access processing of the items of a large memory pool");
+    json_attr_double(json_ctx, "num_items", num_items);
+    json_attr_double(json_ctx, "num_accesses", num_accesses);
+
+    for (int method = 0; method < 2; method++) {
+        boost_intrusive_pool<LargeObject> pool(num_items, BOOST_INTRUSIVE_POOL_INCREASE_STEP,
+            BOOST_INTRUSIVE_POOL_NO_MAX_SIZE, RECYCLE_METHOD_NONE, nullptr, backings[method]);
+        std::vector<HLargeObject> items;
+        items.reserve(num_items);
+        for (size_t i = 0; i < num_items; i++)
+            items.push_back(pool.allocate());
+
+        timing_t start, stop, elapsed, accumulated = 0;
+        for (int k = 0; k < NUM_AVERAGING_RUNS; k++) {
+            char sum = 0;
+            TIMING_NOW(start);
+            for (size_t i = 0; i < num_accesses; i++) {
+                LargeObject* pitem = items[order[i % num_items]].get();
+                int idx = (int)(i % 1024);
+                sum += pitem->read(idx);
+                pitem->write(idx, sum);
+            }
+            TIMING_NOW(stop);
+            TIMING_DIFF(elapsed, start, stop);
+            TIMING_ACCUM(accumulated, elapsed);
+        }
+
+        json_contention_results(json_ctx, names[method], accumulated / NUM_AVERAGING_RUNS, num_accesses);
+        if (backings[method] == MEMORY_BACKING_HUGE_PAGES)
+            json_attr_double(json_ctx, "huge_page_memory", pool.huge_page_memory()); // zero if not available
+    }
+
+    json_attr_object_end(json_ctx); // hugepages
+}
+
+// Measures the first burst of allocations out of a bounded memory pool just created, with and without prefaulting
+// (and locking) its arenas: without prefaulting, the first touch of each page of the pool causes a page fault in
+// the middle of the burst.
+static void do_prefault_benchmark(json_ctx_t* json_ctx)
+{
+    const size_t num_items = PREFAULT_NUM_ITEMS;
+    const memory_backing_e backings[] = { MEMORY_BACKING_DEFAULT, MEMORY_BACKING_PREFAULT, MEMORY_BACKING_LOCKED };
+    const char* names[] = { "default_memory_backing", "prefaulted_memory_backing", "locked_memory_backing" };
+
+    json_attr_object_begin(json_ctx, "prefault");
+    json_attr_string(json_ctx, "desc", "First burst of allocations out of a bounded memory pool");
+    json_attr_double(json_ctx, "num_items", num_items);
+
+    for (int method = 0; method < 3; method++) {
+        timing_t start, stop, elapsed, accumulated = 0;
+        long page_faults = 0, locked_memory = 0;
+        for (int k = 0; k < NUM_AVERAGING_RUNS; k++) {
+            boost_intrusive_pool<LargeObject> pool(num_items, 0 /* bounded */, BOOST_INTRUSIVE_POOL_NO_MAX_SIZE,
+                RECYCLE_METHOD_NONE, nullptr, backings[method]);
+            std::vector<HLargeObject> items(num_items); // touch the memory of the vector before the burst
+            struct rusage usage[2];
+
+            getrusage(RUSAGE_SELF, &usage[0]);
+            TIMING_NOW(start);
+            for (size_t i = 0; i < num_items; i++)
+                items[i] = pool.allocate();
+            TIMING_NOW(stop);
+            getrusage(RUSAGE_SELF, &usage[1]);
+
+            TIMING_DIFF(elapsed, start, stop);
+            TIMING_ACCUM(accumulated, elapsed);
+            page_faults += usage[1].ru_minflt - usage[0].ru_minflt;
+            locked_memory = pool.locked_memory(); // zero if not allowed by RLIMIT_MEMLOCK
+        }
+
+        json_contention_results(json_ctx, names[method], accumulated / NUM_AVERAGING_RUNS, num_items);
+        json_attr_double(json_ctx, (std::string(names[method]) + "_page_faults").c_str(),
+            (double)page_faults / NUM_AVERAGING_RUNS);
+        if (backings[method] == MEMORY_BACKING_LOCKED)
+            json_attr_double(json_ctx, "locked_memory", locked_memory);
+    }
+
+    json_attr_object_end(json_ctx); // prefault
+}
+
+static void do_json_benchmark(std::function<void(json_ctx_t*)> benchmark_fn)
 {
     json_ctx_t json_ctx;
 
     json_init(&json_ctx, 0, stdout);
     json_document_begin(&json_ctx);
-    do_benchmark(&json_ctx);
+    benchmark_fn(&json_ctx);
     json_document_end(&json_ctx);
 
     printf("\n");
@@ -331,22 +1341,51 @@ static void do_json_benchmark()
 
 static void usage(const char* name)
 {
-    fprintf(stderr, "%s: <num_threads>\n", name);
+    fprintf(stderr,
+        "Usage: %s [contention [<num_threads>] | scaling [<max_threads>] | multithread [<max_threads>] | bulk | "
+        "inheritance | hugepages | prefault]\n",
+        name);
     exit(1);
 }
 
 int main(int argc, char** argv)
 {
-    if (argc > 1)
+    if (argc == 1) {
+        // to better simulate a realistic workload use our own benchmarking routines to
+        // defrag a little bit the memory of this process (but do not really write any output!)
+        for (unsigned int i = 0; i < 3; i++)
+            do_benchmark(NULL);
+
+        // final run is to write real output JSON
+        do_json_benchmark(do_benchmark);
+    } else if (strcmp(argv[1], "contention") == 0 && argc <= 3) {
+        unsigned int num_threads = (argc == 3) ? atoi(argv[2]) : std::thread::hardware_concurrency();
+        if (num_threads == 0)
+            usage(argv[0]);
+
+        do_json_benchmark([num_threads](json_ctx_t* json_ctx) { do_contention_benchmark(json_ctx, num_threads); });
+    } else if (strcmp(argv[1], "scaling") == 0 && argc <= 3) {
+        unsigned int max_threads = (argc == 3) ? atoi(argv[2]) : std::thread::hardware_concurrency();
+        if (max_threads == 0)
+            usage(argv[0]);
+
+        do_json_benchmark([max_threads](json_ctx_t* json_ctx) { do_scaling_benchmark(json_ctx, max_threads); });
+    } else if (strcmp(argv[1], "multithread") == 0 && argc <= 3) {
+        unsigned int max_threads = (argc == 3) ? atoi(argv[2]) : std::thread::hardware_concurrency();
+        if (max_threads == 0)
+            usage(argv[0]);
+
+        do_json_benchmark([max_threads](json_ctx_t* json_ctx) { do_multithread_benchmark(json_ctx, max_threads); });
+    } else if (strcmp(argv[1], "bulk") == 0 && argc == 2) {
+        do_json_benchmark(do_bulk_benchmark);
+    } else if (strcmp(argv[1], "inheritance") == 0 && argc == 2) {
+        do_json_benchmark(do_inheritance_benchmark);
+    } else if (strcmp(argv[1], "hugepages") == 0 && argc == 2) {
+        do_json_benchmark(do_hugepages_benchmark);
+    } else if (strcmp(argv[1], "prefault") == 0 && argc == 2) {
+        do_json_benchmark(do_prefault_benchmark);
+    } else
         usage(argv[0]);
 
-    // to better simulate a realistic workload use our own benchmarking routines to
-    // defrag a little bit the memory of this process (but do not really write any output!)
-    for (unsigned int i = 0; i < 3; i++)
-        do_benchmark(NULL);
-
-    // final run is to write real output JSON
-    do_json_benchmark();
-
     return 0;
 }
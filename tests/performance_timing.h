@@ -21,6 +21,15 @@ typedef uint64_t timing_t;
         (var) = (uint64_t)(tv.tv_nsec + (uint64_t)1000000000 * tv.tv_sec);                                             \
     })
 
+/* Wall-clock time: used by multithreaded benchmarks, where the CPU time of the
+   process is the sum of the CPU time of all threads.  */
+#define TIMING_NOW_WALLCLOCK(var)                                                                                      \
+    ({                                                                                                                 \
+        struct timespec tv;                                                                                            \
+        clock_gettime(CLOCK_MONOTONIC, &tv);                                                                           \
+        (var) = (uint64_t)(tv.tv_nsec + (uint64_t)1000000000 * tv.tv_sec);                                             \
+    })
+
 #define TIMING_DIFF(diff, start, end) (diff) = (end) - (start)
 #define TIMING_ACCUM(sum, diff) (sum) += (diff)
 
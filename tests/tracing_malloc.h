@@ -1,6 +1,10 @@
 #pragma once
+#include <malloc.h>
 #include <pthread.h>
 
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
 #include <iostream>
 
 #define TRACE_METHOD() std::cout << "[Executing " << __PRETTY_FUNCTION__ << " for instance=" << this << "]\n";
@@ -9,25 +13,112 @@
 // Utility functions to trace mallocs
 //------------------------------------------------------------------------------
 
+#ifndef TRACING_MALLOC_LOG
+// define to 0 before including this file to count allocations without logging them
+#define TRACING_MALLOC_LOG 1
+#endif
+
+// number of allocations and deallocations done so far, through operator new/delete or through the malloc() family
+std::atomic<size_t> g_num_allocations(0);
+std::atomic<size_t> g_num_deallocations(0);
+
+// with glibc also the malloc() family gets replaced, forwarding to the glibc allocator, so that allocations not
+// going through operator new are counted too; AddressSanitizer replaces malloc() itself, so leave it alone there
+#if defined(__GLIBC__) && !defined(__SANITIZE_ADDRESS__)
+#define TRACING_MALLOC_HOOKS_MALLOC 1
+
+extern "C" {
+void* __libc_malloc(size_t n);
+void* __libc_calloc(size_t count, size_t n);
+void* __libc_realloc(void* p, size_t n);
+void* __libc_memalign(size_t alignment, size_t n);
+void __libc_free(void* p);
+
+void* malloc(size_t n) throw()
+{
+    g_num_allocations++;
+    return __libc_malloc(n);
+}
+
+void* calloc(size_t count, size_t n) throw()
+{
+    g_num_allocations++;
+    return __libc_calloc(count, n);
+}
+
+void* realloc(void* p, size_t n) throw()
+{
+    g_num_allocations++;
+    return __libc_realloc(p, n);
+}
+
+void* memalign(size_t alignment, size_t n) throw()
+{
+    g_num_allocations++;
+    return __libc_memalign(alignment, n);
+}
+
+void* aligned_alloc(size_t alignment, size_t n) throw() { return memalign(alignment, n); }
+
+int posix_memalign(void** p, size_t alignment, size_t n) throw()
+{
+    void* ret = memalign(alignment, n);
+    if (!ret)
+        return ENOMEM;
+    *p = ret;
+    return 0;
+}
+
+void free(void* p) throw()
+{
+    if (p)
+        g_num_deallocations++;
+    __libc_free(p);
+}
+}
+#else
+#define TRACING_MALLOC_HOOKS_MALLOC 0
+#endif
+
 // replace operator new and delete to log allocations
 void* operator new(std::size_t n)
 {
     void* ret = malloc(n);
-    std::cout << "[Allocating " << n << "bytes: " << ret << "]" << std::endl;
+    if (!TRACING_MALLOC_HOOKS_MALLOC)
+        g_num_allocations++;
+    if (TRACING_MALLOC_LOG)
+        std::cout << "[Allocating " << n << "bytes: " << ret << "]" << std::endl;
     return ret;
 }
 
 void operator delete(void* p) throw()
 {
-    std::cout << "[Freeing " << p << "]" << std::endl;
+    if (!TRACING_MALLOC_HOOKS_MALLOC && p)
+        g_num_deallocations++;
+    if (TRACING_MALLOC_LOG)
+        std::cout << "[Freeing " << p << "]" << std::endl;
     free(p);
 }
 
-void operator delete(void* p, size_t n) throw()
-{
-    std::cout << "[Freeing " << p << "]" << std::endl;
-    free(p);
-}
+void operator delete(void* p, size_t n) throw() { operator delete(p); }
+
+// counts the allocations and deallocations done, by any thread, since its construction:
+// a piece of code does not touch the heap if both counts are zero after it runs
+class tracing_malloc_scope {
+public:
+    tracing_malloc_scope()
+        : m_num_allocations(g_num_allocations)
+        , m_num_deallocations(g_num_deallocations)
+    {
+    }
+
+    size_t allocations() const { return g_num_allocations - m_num_allocations; }
+    size_t deallocations() const { return g_num_deallocations - m_num_deallocations; }
+
+private:
+    size_t m_num_allocations;
+    size_t m_num_deallocations;
+};
 
 void print_header()
 {
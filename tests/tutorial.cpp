@@ -223,6 +223,8 @@ void showcase_boost_intrusive_pool()
 
     std::cout << "Note that the overhead of memory pool support is sizeof(memorypool::boost_intrusive_pool_item)="
               << sizeof(memorypool::boost_intrusive_pool_item) << "bytes" << std::endl;
+    std::cout << "or sizeof(memorypool::boost_intrusive_pool_compact_item)="
+              << sizeof(memorypool::boost_intrusive_pool_compact_item) << "bytes with compact items" << std::endl;
 }
 
 //------------------------------------------------------------------------------
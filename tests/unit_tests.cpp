@@ -19,11 +19,15 @@
 #define BOOST_INTRUSIVE_POOL_DEBUG_CHECKS 1
 #include "boost_intrusive_pool.hpp"
 
+#define TRACING_MALLOC_LOG 0 // just count the allocations
+#include "tracing_malloc.h"
+
 #include <cstdint>
 #include <functional>
 #include <malloc.h>
 #include <memory>
 #include <mutex>
+#include <set>
 #include <thread>
 #include <type_traits>
 
@@ -106,6 +110,132 @@ struct dummy_three : std::enable_shared_from_this<dummy_three>, public boost_int
 
 int32_t dummy_three::m_count = 0;
 
+// dummy objects with a 3-level class hierarchy, where the memory-pooled class has multiple base classes
+struct dummy_level1 : public boost_intrusive_pool_item {
+    virtual int level() const { return 1; }
+};
+
+struct dummy_level2 : public dummy_level1 {
+    virtual int level() const override { return 2; }
+};
+
+struct dummy_level3 : public std::enable_shared_from_this<dummy_level3>, public dummy_level2 {
+    virtual int level() const override { return 3; }
+    virtual void destroy() override { m_destroyed = true; }
+
+    void init() { m_destroyed = false; }
+
+    bool m_destroyed = false;
+};
+
+// dummy object whose intrusive_ptr<> can be shared among threads
+struct dummy_shared : public boost_intrusive_pool_item {
+    typedef boost_intrusive_pool_thread_safe_counter boost_intrusive_pool_counter_policy;
+
+    void init(uint32_t value = 0) { m_value = value; }
+
+    uint32_t m_value = 0;
+};
+
+// dummy object using the compact 8-byte header
+struct dummy_compact : public boost_intrusive_pool_compact_item {
+    dummy_compact() { ++m_count; }
+    ~dummy_compact() { --m_count; }
+
+    void init(uint32_t value = 0) { m_value = value; }
+    void destroy() { m_value = 0; }
+
+    uint32_t m_value = 0;
+
+    static int32_t m_count;
+};
+
+int32_t dummy_compact::m_count = 0;
+
+static_assert(sizeof(dummy_compact) == 8 + sizeof(uint32_t), "the header of compact items must be 8 bytes");
+
+// dummy object without a default ctor, which can be pooled only with RECYCLE_METHOD_DTOR
+struct dummy_no_default_ctor : public boost_intrusive_pool_item {
+    dummy_no_default_ctor(uint32_t value, const std::string& name)
+        : m_value(value)
+        , m_name(name)
+    {
+        ++m_count;
+    }
+    ~dummy_no_default_ctor() { --m_count; }
+
+    uint32_t m_value;
+    std::string m_name;
+
+    static int32_t m_count;
+};
+
+int32_t dummy_no_default_ctor::m_count = 0;
+
+typedef boost::intrusive_ptr<dummy_no_default_ctor> HDummyNoDefaultCtor;
+
+// recycle policy counting the items returning into their memory pool
+struct counting_recycle {
+    template <typename Item> void operator()(Item&) const { m_count++; }
+
+    static size_t m_count;
+};
+
+size_t counting_recycle::m_count = 0;
+
+// item whose destroy() function is overloaded, so that it has no single address
+struct dummy_overloaded_destroy : public boost_intrusive_pool_item {
+    void init() { }
+    void destroy() { m_destroyed = true; }
+    void destroy(bool destroyed) { m_destroyed = destroyed; }
+
+    bool m_destroyed = false;
+};
+
+static_assert(std::is_same<DummyInt::boost_intrusive_pool_counter_policy,
+                  boost_intrusive_pool_thread_unsafe_counter>::value,
+    "the default refcount policy must be the non-atomic one");
+static_assert(!boost_intrusive_pool_growth_uses_elapsed_time<boost_intrusive_pool_geometric_growth>::value
+        && boost_intrusive_pool_growth_uses_elapsed_time<boost_intrusive_pool_adaptive_growth>::value
+        && boost_intrusive_pool_growth_uses_elapsed_time<boost_intrusive_pool_growth_function>::value,
+    "only the growth policies using the time elapsed between enlarge steps must read the clock");
+
+// memory source carving the arenas out of a region preallocated at startup, like a monotonic allocator
+class region_memory_source : public boost_intrusive_pool_memory_source {
+public:
+    region_memory_source(size_t size)
+    {
+        BOOST_REQUIRE(posix_memalign((void**)&m_region, BOOST_INTRUSIVE_POOL_SEGMENT_SIZE, size) == 0);
+        m_size = size;
+    }
+    ~region_memory_source() { free(m_region); }
+
+    void* allocate_bytes(size_t size, size_t alignment) override
+    {
+        size_t start = (m_used + alignment - 1) & ~(alignment - 1);
+        if (start + size > m_size)
+            return nullptr;
+        m_used = start + size;
+        m_num_allocations++;
+        return m_region + start;
+    }
+    void deallocate_bytes(void* p, size_t, size_t) override
+    {
+        BOOST_REQUIRE(contains(p));
+        m_num_deallocations++;
+    }
+
+    bool contains(const void* p) const { return p >= m_region && p < m_region + m_size; }
+
+    size_t m_num_allocations = 0;
+    size_t m_num_deallocations = 0;
+
+private:
+    char* m_region;
+    size_t m_size;
+    size_t m_used = 0;
+};
+
 //------------------------------------------------------------------------------
 // Actual testcases
 //------------------------------------------------------------------------------
@@ -337,7 +467,6 @@ void test_api()
 
         auto recycle_fn = [&recycled](dummy_one& object) {
             BOOST_REQUIRE(object.m_count > 0);
-            object.m_count--;
             ++recycled;
         };
 
@@ -360,10 +489,10 @@ void test_api()
 
         BOOST_REQUIRE_EQUAL(pool.unused_count(), BOOST_INTRUSIVE_POOL_DEFAULT_POOL_SIZE - 2);
 
-        // the dummy_one::m_count counter is off by 1 because above we called an allocate() and
-        // then destroyed the "d1" pointer: that resulted in the item being recycled and dummy_one::~dummy_one
-        // being called
-        BOOST_REQUIRE_EQUAL(dummy_one::m_count, BOOST_INTRUSIVE_POOL_DEFAULT_POOL_SIZE - 1);
+        // items are constructed only when they are allocated for the first time: above we called an allocate() and
+        // then destroyed the "d1" pointer: that resulted in the item being recycled and reused for "d2"
+        BOOST_REQUIRE_EQUAL(dummy_one::m_count, 2);
+        BOOST_REQUIRE_EQUAL(recycled, 1);
 
         {
             auto d4 = pool.allocate();
@@ -391,13 +520,13 @@ void test_allocate_methods()
         auto o1 = pool.allocate();
         auto o2 = pool.allocate();
 
-        // the pool constructs BOOST_INTRUSIVE_POOL_DEFAULT_POOL_SIZE items
-        // and then we did not call any ctor (using allocate() nothing gets called inside
+        // the pool constructs its items only when they are allocated for the first time
+        // and then we did not call any other ctor (using allocate() nothing else gets called inside
         // the dummy_two class):
-        BOOST_REQUIRE_EQUAL(dummy_two::m_count, BOOST_INTRUSIVE_POOL_DEFAULT_POOL_SIZE);
+        BOOST_REQUIRE_EQUAL(dummy_two::m_count, 2);
     }
 
-    // now all BOOST_INTRUSIVE_POOL_DEFAULT_POOL_SIZE items have been destroyed through
+    // now all constructed items have been destroyed through
     // their dtor so the count returns to zero:
     BOOST_REQUIRE_EQUAL(dummy_two::m_count, 0);
 
@@ -409,15 +538,905 @@ void test_allocate_methods()
         auto o1 = pool.allocate_through_init(3U);
         auto o2 = pool.allocate_through_init(3U);
 
-        // the pool constructs BOOST_INTRUSIVE_POOL_DEFAULT_POOL_SIZE items
-        BOOST_REQUIRE_EQUAL(dummy_two::m_count, BOOST_INTRUSIVE_POOL_DEFAULT_POOL_SIZE);
+        // the pool constructs its items only when they are allocated for the first time
+        BOOST_REQUIRE_EQUAL(dummy_two::m_count, 2);
     }
 
-    // now all BOOST_INTRUSIVE_POOL_DEFAULT_POOL_SIZE items have been destroyed through
+    // now all constructed items have been destroyed through
     // their dtor so it just remains an offset = 2 in the static instance count:
     BOOST_REQUIRE_EQUAL(dummy_two::m_count, 0);
 }
 
+void test_allocate_bulk_methods()
+{
+    BOOST_TEST_MESSAGE("Starting tests of the bulk allocate methods");
+
+    {
+        // unbounded pool: a bulk allocation bigger than the free list enlarges the pool just once
+        boost_intrusive_pool<DummyInt> pool(10, 10 /* enlarge step */);
+        std::vector<HDummyInt> helper_container;
+
+        BOOST_REQUIRE_EQUAL(pool.allocate_bulk(5, std::back_inserter(helper_container)), 5);
+        BOOST_REQUIRE_EQUAL(pool.enlarge_steps_done(), 1);
+
+        BOOST_REQUIRE_EQUAL(pool.allocate_bulk_through_init(40, std::back_inserter(helper_container), 7), 40);
+        BOOST_REQUIRE_EQUAL(pool.enlarge_steps_done(), 2);
+        BOOST_REQUIRE_EQUAL(helper_container.size(), 45);
+        for (unsigned int j = 5; j < helper_container.size(); j++)
+            BOOST_REQUIRE(*helper_container[j] == DummyInt(7));
+
+        // all items must be distinct
+        std::set<DummyInt*> unique_items;
+        for (auto& item : helper_container)
+            unique_items.insert(item.get());
+        BOOST_REQUIRE_EQUAL(unique_items.size(), 45);
+
+        BOOST_REQUIRE_EQUAL(pool.inuse_count(), 45);
+        BOOST_REQUIRE(pool.unused_count() > 0); // the free list never remains empty for unbounded pools
+        pool.check();
+
+        BOOST_REQUIRE_EQUAL(pool.allocate_bulk(0, std::back_inserter(helper_container)), 0);
+
+        helper_container.clear();
+        pool.check();
+        BOOST_REQUIRE(pool.empty());
+    }
+
+    {
+        // bounded pool: a bulk allocation delivers only the available items
+        boost_intrusive_pool<DummyInt> pool(10, 0 /* enlarge step */);
+        HDummyInt items[16];
+
+        size_t count = pool.allocate_bulk_through_function(16, items, [](DummyInt& item) { item.init(3); });
+        BOOST_REQUIRE_EQUAL(count, 10);
+        for (unsigned int j = 0; j < count; j++)
+            BOOST_REQUIRE(items[j] && *items[j] == DummyInt(3));
+        BOOST_REQUIRE(!items[10]);
+        BOOST_REQUIRE(pool.is_memory_exhausted());
+
+        BOOST_REQUIRE_EQUAL(pool.allocate_bulk(1, items + 10), 0);
+        pool.check();
+
+        for (unsigned int j = 0; j < count; j++)
+            items[j] = nullptr;
+        pool.check();
+        BOOST_REQUIRE_EQUAL(pool.unused_count(), 10);
+    }
+
+    {
+        // pool with maximum size: a bulk allocation enlarges up to the maximum size
+        boost_intrusive_pool<DummyInt> pool(10, 10 /* enlarge step */, 25 /* max size */);
+        std::vector<HDummyInt> helper_container;
+
+        BOOST_REQUIRE_EQUAL(pool.allocate_bulk(30, std::back_inserter(helper_container)), 25);
+        BOOST_REQUIRE_EQUAL(pool.capacity(), 25);
+        BOOST_REQUIRE(pool.is_memory_exhausted());
+        pool.check();
+    }
+}
+
+/// Test that allocate_through_function() does not wrap the callable into a heap-allocating std::function
+void test_allocate_through_function_without_malloc()
+{
+    BOOST_TEST_MESSAGE("Starting tests of allocate_through_function() with callables not fitting std::function");
+
+    // std::function allocates on the heap the callables which do not fit its small buffer, like this one:
+    uint64_t a = 1, b = 2, c = 3, d = 4;
+    auto init_fn = [a, b, c, d](DummyInt& item) { item.init((int)(a + b + c + d)); };
+    size_t num_allocations = g_num_allocations;
+    std::function<void(DummyInt&)> wrapped_fn(init_fn);
+    BOOST_REQUIRE(g_num_allocations > num_allocations);
+
+    boost_intrusive_pool<DummyInt> pool(100, 100);
+    concurrent_boost_intrusive_pool<DummyInt> concurrent_pool(100, 100);
+    sharded_boost_intrusive_pool<DummyInt> sharded_pool(100, 100);
+    std::vector<HDummyInt> items;
+    items.reserve(16);
+
+    // none of the memory pools allocates memory while invoking the callable
+    num_allocations = g_num_allocations;
+    items.push_back(pool.allocate_through_function(init_fn));
+    items.push_back(concurrent_pool.allocate_through_function(init_fn));
+    items.push_back(sharded_pool.allocate_through_function(init_fn));
+    pool.allocate_bulk_through_function(4, std::back_inserter(items), init_fn);
+    size_t new_allocations = g_num_allocations - num_allocations;
+    BOOST_REQUIRE_EQUAL(new_allocations, 0);
+
+    BOOST_REQUIRE_EQUAL(items.size(), 7);
+    for (const HDummyInt& item : items)
+        BOOST_REQUIRE(*item == DummyInt(10));
+
+    // std::function is accepted as well
+    BOOST_REQUIRE(*pool.allocate_through_function(wrapped_fn) == DummyInt(10));
+    BOOST_REQUIRE(*sharded_pool.allocate_through_function(wrapped_fn) == DummyInt(10));
+}
+
+// Runs all the allocate methods of the given memory pool and then recycles the allocated items
+template <typename Pool> void allocate_and_recycle(Pool& pool, std::vector<HDummyInt>& items)
+{
+    uint64_t a = 1, b = 2, c = 3, d = 4; // too big to fit the small buffer of std::function
+    for (int j = 0; j < 8; j++) {
+        items.push_back(pool.allocate());
+        items.push_back(pool.allocate_through_init(j));
+        items.push_back(
+            pool.allocate_through_function([a, b, c, d](DummyInt& item) { item.init((int)(a + b + c + d)); }));
+    }
+    items.clear();
+}
+
+void test_zero_malloc_allocate_and_recycle()
+{
+    BOOST_TEST_MESSAGE("Starting tests checking that allocating and recycling items never touches the heap");
+
+    // the counters see the allocations done by the memory pools, e.g. when they enlarge:
+    {
+        tracing_malloc_scope scope;
+        boost_intrusive_pool<DummyInt> pool(1, 1);
+        pool.allocate();
+        size_t allocations = scope.allocations();
+        BOOST_REQUIRE(allocations > 0);
+    }
+
+    unsigned int num_recycled = 0;
+    auto count_recycled = [&num_recycled](DummyInt&) { num_recycled++; };
+    const recycle_method_e methods[] = { RECYCLE_METHOD_NONE, RECYCLE_METHOD_DESTROY_FUNCTION,
+        RECYCLE_METHOD_CUSTOM_FUNCTION, RECYCLE_METHOD_DTOR };
+    for (recycle_method_e method : methods) {
+        std::function<void(DummyInt&)> recycle_fn;
+        if (method == RECYCLE_METHOD_CUSTOM_FUNCTION)
+            recycle_fn = count_recycled;
+
+        boost_intrusive_pool<DummyInt> pool(100, 100, BOOST_INTRUSIVE_POOL_NO_MAX_SIZE, method, recycle_fn);
+        concurrent_boost_intrusive_pool<DummyInt> concurrent_pool(
+            100, 100, BOOST_INTRUSIVE_POOL_NO_MAX_SIZE, method, recycle_fn);
+        sharded_boost_intrusive_pool<DummyInt> sharded_pool(
+            100, 100, BOOST_INTRUSIVE_POOL_NO_MAX_SIZE, method, recycle_fn);
+        std::vector<HDummyInt> items;
+        items.reserve(100);
+
+        tracing_malloc_scope scope;
+        allocate_and_recycle(pool, items);
+        allocate_and_recycle(concurrent_pool, items);
+        allocate_and_recycle(sharded_pool, items);
+        BOOST_REQUIRE_EQUAL(pool.allocate_bulk(10, std::back_inserter(items)), 10);
+        BOOST_REQUIRE_EQUAL(pool.allocate_bulk_through_init(10, std::back_inserter(items), 5), 10);
+        pool.release_bulk(items);
+        items.clear();
+        size_t allocations = scope.allocations(), deallocations = scope.deallocations();
+        BOOST_REQUIRE_EQUAL(allocations, 0);
+        BOOST_REQUIRE_EQUAL(deallocations, 0);
+
+        pool.check();
+        concurrent_pool.check();
+        sharded_pool.check();
+    }
+    BOOST_REQUIRE_EQUAL(num_recycled, 3 * 24 + 20);
+
+    // the same holds for compact items and for compile-time recycle policies
+    {
+        boost_intrusive_pool<dummy_compact> pool(100, 100);
+        boost_intrusive_pool<DummyInt, boost_intrusive_pool_auto_recycle> policy_pool(100, 100);
+        std::vector<HDummyInt> items;
+        items.reserve(100);
+
+        tracing_malloc_scope scope;
+        for (uint32_t j = 0; j < 10; j++) {
+            boost::intrusive_ptr<dummy_compact> item = pool.allocate_through_init(j);
+            item = pool.allocate();
+        }
+        allocate_and_recycle(policy_pool, items);
+        size_t allocations = scope.allocations(), deallocations = scope.deallocations();
+        BOOST_REQUIRE_EQUAL(allocations, 0);
+        BOOST_REQUIRE_EQUAL(deallocations, 0);
+    }
+}
+
+void test_zero_malloc_intrusive_ptr()
+{
+    BOOST_TEST_MESSAGE("Starting tests checking that copying and moving memory-pooled items never touches the heap");
+
+    boost_intrusive_pool<DummyInt> pool(10, 10);
+    concurrent_boost_intrusive_pool<dummy_shared> concurrent_pool(10, 10);
+    HDummyInt item = pool.allocate_through_init(3);
+    boost::intrusive_ptr<dummy_shared> shared_item = concurrent_pool.allocate();
+
+    tracing_malloc_scope scope;
+    {
+        HDummyInt copy(item), other_copy;
+        other_copy = copy;
+        HDummyInt moved(std::move(copy));
+        other_copy = std::move(moved);
+        other_copy.swap(copy);
+
+        boost::intrusive_ptr<dummy_shared> shared_copy(shared_item), shared_moved;
+        shared_moved = std::move(shared_copy);
+    }
+    item = nullptr; // the last reference goes away: back into the memory pool
+    shared_item.reset();
+    size_t allocations = scope.allocations(), deallocations = scope.deallocations();
+    BOOST_REQUIRE_EQUAL(allocations, 0);
+    BOOST_REQUIRE_EQUAL(deallocations, 0);
+    BOOST_REQUIRE_EQUAL(pool.inuse_count(), 0);
+    BOOST_REQUIRE_EQUAL(concurrent_pool.inuse_count(), 0);
+}
+
+/// Test that enlarging the pool does not construct any item: items are constructed only when they are allocated
+/// for the first time, after all recycled items have been reused
+void test_lazy_construction()
+{
+    BOOST_TEST_MESSAGE("Starting tests of the lazy construction of items");
+
+    dummy_one::m_count = 0;
+    {
+        boost_intrusive_pool<dummy_one> pool(512 * 1024, 1024);
+        BOOST_REQUIRE_EQUAL(pool.capacity(), 512 * 1024);
+        BOOST_REQUIRE_EQUAL(pool.unused_count(), 512 * 1024);
+        BOOST_REQUIRE_EQUAL(dummy_one::m_count, 0);
+
+        std::vector<boost::intrusive_ptr<dummy_one>> items;
+        for (unsigned int j = 0; j < 10; j++)
+            items.push_back(pool.allocate());
+        BOOST_REQUIRE_EQUAL(dummy_one::m_count, 10);
+        for (unsigned int j = 1; j < 10; j++)
+            BOOST_REQUIRE(items[j].get() != items[j - 1].get());
+
+        // recycled items are reused before constructing new ones:
+        dummy_one* recycled = items.back().get();
+        items.pop_back();
+        items.push_back(pool.allocate());
+        BOOST_REQUIRE(items.back().get() == recycled);
+        BOOST_REQUIRE_EQUAL(dummy_one::m_count, 10);
+
+        // a bulk allocation takes both the recycled items and new ones:
+        items.resize(7);
+        BOOST_REQUIRE_EQUAL(pool.allocate_bulk(5, std::back_inserter(items)), 5);
+        BOOST_REQUIRE_EQUAL(dummy_one::m_count, 12);
+        BOOST_REQUIRE_EQUAL(pool.inuse_count(), 12);
+        BOOST_REQUIRE_EQUAL(pool.unused_count(), 512 * 1024 - 12);
+        pool.check();
+    }
+    BOOST_REQUIRE_EQUAL(dummy_one::m_count, 0);
+}
+
+void test_huge_pages()
+{
+    BOOST_TEST_MESSAGE("Starting tests of memory pools backed by huge pages");
+
+    {
+        boost_intrusive_pool<DummyInt> pool(100, 100);
+        BOOST_REQUIRE_EQUAL(pool.huge_page_memory(), 0);
+    }
+
+    // huge pages might not be available: in such case the pool falls back to the heap and works the same way
+    {
+        boost_intrusive_pool<DummyInt> pool(
+            100, 100, BOOST_INTRUSIVE_POOL_NO_MAX_SIZE, RECYCLE_METHOD_NONE, nullptr, MEMORY_BACKING_HUGE_PAGES);
+        size_t huge_page_memory = pool.huge_page_memory();
+        BOOST_REQUIRE(huge_page_memory == 0 || huge_page_memory == BOOST_INTRUSIVE_POOL_HUGE_PAGE_SIZE);
+
+        // enlarge steps use the rest of the arena, which was rounded up to a whole huge page
+        std::vector<HDummyInt> items;
+        for (int j = 0; j < 250; j++)
+            items.push_back(pool.allocate_through_init(j));
+        BOOST_REQUIRE_EQUAL(pool.capacity(), 300);
+        BOOST_REQUIRE_EQUAL(pool.enlarge_steps_done(), 3);
+        BOOST_REQUIRE_EQUAL(pool.huge_page_memory(), huge_page_memory);
+        for (int j = 0; j < 250; j++)
+            BOOST_REQUIRE(*items[j] == DummyInt(j));
+        pool.check();
+
+        // clear() keeps the memory backing of the pool
+        items.clear();
+        pool.clear();
+        items.push_back(pool.allocate());
+        BOOST_REQUIRE_EQUAL(pool.huge_page_memory(), huge_page_memory);
+    }
+
+    {
+        concurrent_boost_intrusive_pool<DummyInt> pool(
+            100, 100, BOOST_INTRUSIVE_POOL_NO_MAX_SIZE, RECYCLE_METHOD_NONE, nullptr, MEMORY_BACKING_HUGE_PAGES);
+        std::vector<HDummyInt> items;
+        for (int j = 0; j < 250; j++)
+            items.push_back(pool.allocate());
+        BOOST_REQUIRE_EQUAL(pool.capacity(), 300);
+        BOOST_REQUIRE(pool.huge_page_memory() % BOOST_INTRUSIVE_POOL_HUGE_PAGE_SIZE == 0);
+    }
+}
+
+void test_prefaulted_arenas()
+{
+    BOOST_TEST_MESSAGE("Starting tests of memory pools with prefaulted and locked arenas");
+
+    {
+        boost_intrusive_pool<DummyInt> pool(
+            100, 100, BOOST_INTRUSIVE_POOL_NO_MAX_SIZE, RECYCLE_METHOD_NONE, nullptr, MEMORY_BACKING_PREFAULT);
+        BOOST_REQUIRE_EQUAL(pool.locked_memory(), 0);
+    }
+
+    // locking might not be allowed by RLIMIT_MEMLOCK: in such case the arenas are just prefaulted
+    {
+        const size_t step = boost_intrusive_pool_arena<DummyInt>::items_per_segment() + 1;
+        boost_intrusive_pool<DummyInt> pool(
+            step, step, BOOST_INTRUSIVE_POOL_NO_MAX_SIZE, RECYCLE_METHOD_NONE, nullptr, MEMORY_BACKING_LOCKED);
+        size_t locked_memory = pool.locked_memory();
+        BOOST_REQUIRE(locked_memory == 0 || locked_memory == 2 * BOOST_INTRUSIVE_POOL_SEGMENT_SIZE);
+
+        std::vector<HDummyInt> items;
+        for (unsigned int j = 0; j < step; j++)
+            items.push_back(pool.allocate_through_init(j));
+        BOOST_REQUIRE_EQUAL(pool.capacity(), 2 * step);
+        BOOST_REQUIRE_EQUAL(pool.locked_memory(), 2 * locked_memory);
+        for (unsigned int j = 0; j < step; j++)
+            BOOST_REQUIRE(*items[j] == DummyInt(j));
+        pool.check();
+
+        // released arenas are unlocked
+        items.clear();
+        BOOST_REQUIRE_EQUAL(pool.trim(1), step);
+        BOOST_REQUIRE_EQUAL(pool.locked_memory(), locked_memory);
+    }
+
+    // the flags can be combined with huge pages, and a bounded pool never touches new memory after its creation
+    {
+        sharded_boost_intrusive_pool<DummyInt> pool(1000, 0 /* enlarge step */, BOOST_INTRUSIVE_POOL_NO_MAX_SIZE,
+            RECYCLE_METHOD_NONE, nullptr, 2, MEMORY_BACKING_HUGE_PAGES | MEMORY_BACKING_LOCKED);
+        std::vector<HDummyInt> items;
+        for (int j = 0; j < 1000; j++)
+            items.push_back(pool.allocate());
+        BOOST_REQUIRE_EQUAL(pool.capacity(), 1000);
+        BOOST_REQUIRE(pool.locked_memory() % BOOST_INTRUSIVE_POOL_SEGMENT_SIZE == 0);
+        BOOST_REQUIRE(pool.allocate() == nullptr);
+    }
+}
+
+void test_memory_source()
+{
+    BOOST_TEST_MESSAGE("Starting tests of memory pools taking their memory from a custom memory source");
+
+    const size_t step = boost_intrusive_pool_arena<DummyInt>::items_per_segment(); // one segment for each arena
+    region_memory_source source(4 * BOOST_INTRUSIVE_POOL_SEGMENT_SIZE);
+    {
+        boost_intrusive_pool<DummyInt> pool(step, step, BOOST_INTRUSIVE_POOL_NO_MAX_SIZE, RECYCLE_METHOD_NONE, nullptr,
+            MEMORY_BACKING_DEFAULT, &source);
+        std::vector<HDummyInt> items;
+        for (unsigned int j = 0; j < 4 * step; j++) {
+            items.push_back(pool.allocate_through_init(j));
+            BOOST_REQUIRE(source.contains(items.back().get()));
+        }
+        BOOST_REQUIRE_EQUAL(pool.capacity(), 4 * step);
+        BOOST_REQUIRE_EQUAL(source.m_num_allocations, 4);
+
+        // once the memory source is exhausted, the pool cannot grow anymore
+        BOOST_REQUIRE(pool.allocate() == nullptr);
+        for (unsigned int j = 0; j < 4 * step; j++)
+            BOOST_REQUIRE(*items[j] == DummyInt(j));
+        pool.check();
+
+        // released arenas go back to the memory source
+        items.resize(step - 1);
+        BOOST_REQUIRE_EQUAL(pool.trim(1), 3 * step);
+        BOOST_REQUIRE_EQUAL(source.m_num_deallocations, 3);
+    }
+    BOOST_REQUIRE_EQUAL(source.m_num_deallocations, 4);
+
+    region_memory_source other_source(BOOST_INTRUSIVE_POOL_SEGMENT_SIZE);
+    {
+        concurrent_boost_intrusive_pool<DummyInt> pool(step, step, BOOST_INTRUSIVE_POOL_NO_MAX_SIZE,
+            RECYCLE_METHOD_NONE, nullptr, MEMORY_BACKING_PREFAULT, &other_source);
+        HDummyInt item = pool.allocate();
+        BOOST_REQUIRE(other_source.contains(item.get()));
+    }
+    BOOST_REQUIRE_EQUAL(other_source.m_num_deallocations, other_source.m_num_allocations);
+}
+
+// returns the number of items of the given memory pool whose memory is bound to any NUMA node
+template <typename Pool> size_t numa_bound_capacity(const Pool& pool)
+{
+    size_t count = 0;
+    for (int node = 0; node < BOOST_INTRUSIVE_POOL_MAX_NUMA_NODES; node++)
+        count += pool.numa_node_capacity(node);
+    return count;
+}
+
+void test_numa_placement()
+{
+    BOOST_TEST_MESSAGE("Starting tests of memory pools binding their arenas to NUMA nodes");
+
+    // the machine might not support NUMA: in such case the arenas are not bound to any node
+    {
+        const size_t step = boost_intrusive_pool_arena<DummyInt>::items_per_segment(); // one segment for each arena
+        boost_intrusive_pool<DummyInt> pool(
+            step, step, BOOST_INTRUSIVE_POOL_NO_MAX_SIZE, RECYCLE_METHOD_NONE, nullptr, MEMORY_BACKING_NUMA_LOCAL);
+        std::vector<HDummyInt> items;
+        for (unsigned int j = 0; j < 2 * step; j++)
+            items.push_back(pool.allocate_through_init(j));
+        BOOST_REQUIRE_EQUAL(pool.capacity(), 3 * step);
+        bool bound = numa_bound_capacity(pool) > 0;
+        BOOST_REQUIRE_EQUAL(numa_bound_capacity(pool), bound ? pool.capacity() : 0);
+        for (unsigned int j = 0; j < 2 * step; j++) {
+            BOOST_REQUIRE(*items[j] == DummyInt(j));
+            if (bound)
+                BOOST_REQUIRE(pool.numa_node_capacity(boost_intrusive_pool_get_numa_node_of(items[j].get())) > 0);
+        }
+        pool.check();
+
+        // the capacity of the released arenas is not bound anymore
+        items.resize(step - 1);
+        BOOST_REQUIRE_EQUAL(pool.trim(1), 2 * step);
+        BOOST_REQUIRE_EQUAL(numa_bound_capacity(pool), bound ? step : 0);
+    }
+
+    // a memory source can bind the arenas to a given node
+    {
+        boost_intrusive_pool_numa_memory_source source(std::max(boost_intrusive_pool_get_current_numa_node(), 0));
+        concurrent_boost_intrusive_pool<DummyInt> pool(
+            100, 100, BOOST_INTRUSIVE_POOL_NO_MAX_SIZE, RECYCLE_METHOD_NONE, nullptr, MEMORY_BACKING_PREFAULT, &source);
+        HDummyInt item = pool.allocate_through_init(1u);
+        BOOST_REQUIRE(*item == DummyInt(1));
+        size_t bound_count = pool.numa_node_capacity(source.get_numa_node());
+        BOOST_REQUIRE(bound_count == 0 || bound_count == pool.capacity());
+        BOOST_REQUIRE_EQUAL(numa_bound_capacity(pool), bound_count);
+    }
+
+    // each enlarge step of a sharded pool is bound to the node of the shard running out of items
+    {
+        sharded_boost_intrusive_pool<DummyInt> pool(100, 100, BOOST_INTRUSIVE_POOL_NO_MAX_SIZE, RECYCLE_METHOD_NONE,
+            nullptr, 2, MEMORY_BACKING_NUMA_LOCAL | MEMORY_BACKING_HUGE_PAGES);
+        std::vector<HDummyInt> items;
+        for (int j = 0; j < 300; j++)
+            items.push_back(pool.allocate());
+        size_t bound_count = numa_bound_capacity(pool);
+        BOOST_REQUIRE(bound_count == 0 || bound_count == pool.capacity());
+        pool.check();
+    }
+}
+
+void test_dtor_recycle_method()
+{
+    BOOST_TEST_MESSAGE("Starting tests of memory pools running the ctor and the dtor of their items");
+
+    {
+        boost_intrusive_pool<dummy_no_default_ctor> pool(4, 4, BOOST_INTRUSIVE_POOL_NO_MAX_SIZE, RECYCLE_METHOD_DTOR);
+        BOOST_REQUIRE_EQUAL(dummy_no_default_ctor::m_count, 0); // free items are just raw storage
+
+        std::vector<HDummyNoDefaultCtor> items;
+        for (uint32_t j = 0; j < 10; j++) {
+            items.push_back(pool.allocate_through_init(j, std::string("single")));
+            BOOST_REQUIRE_EQUAL(items.back()->m_value, j);
+        }
+        BOOST_REQUIRE_EQUAL(dummy_no_default_ctor::m_count, 10);
+        pool.check();
+
+        // the dtor runs as soon as the items return into the pool...
+        items.resize(5);
+        BOOST_REQUIRE_EQUAL(dummy_no_default_ctor::m_count, 5);
+        BOOST_REQUIRE_EQUAL(pool.inuse_count(), 5);
+        pool.check();
+
+        // ...and the ctor runs again when they are allocated
+        BOOST_REQUIRE_EQUAL(pool.allocate_bulk_through_init(8, std::back_inserter(items), 42u, std::string("bulk")), 8);
+        BOOST_REQUIRE_EQUAL(dummy_no_default_ctor::m_count, 13);
+        BOOST_REQUIRE_EQUAL(items.back()->m_value, 42);
+        BOOST_REQUIRE_EQUAL(items.back()->m_name, "bulk");
+        BOOST_REQUIRE(items.back()->is_in_memory_pool());
+        pool.check();
+
+        pool.release_bulk(items);
+        BOOST_REQUIRE_EQUAL(dummy_no_default_ctor::m_count, 0);
+        BOOST_REQUIRE_EQUAL(pool.inuse_count(), 0);
+        pool.check();
+    }
+
+    {
+        concurrent_boost_intrusive_pool<dummy_no_default_ctor> pool(
+            4, 4, BOOST_INTRUSIVE_POOL_NO_MAX_SIZE, RECYCLE_METHOD_DTOR);
+        sharded_boost_intrusive_pool<dummy_no_default_ctor> sharded_pool(
+            4, 4, BOOST_INTRUSIVE_POOL_NO_MAX_SIZE, RECYCLE_METHOD_DTOR);
+        HDummyNoDefaultCtor item = pool.allocate_through_init(1u, std::string("concurrent"));
+        HDummyNoDefaultCtor sharded_item = sharded_pool.allocate_through_init(2u, std::string("sharded"));
+        {
+            std::vector<HDummyNoDefaultCtor> items;
+            for (uint32_t j = 0; j < 10; j++) {
+                items.push_back(pool.allocate_through_init(j, std::string("concurrent")));
+                items.push_back(sharded_pool.allocate_through_init(j, std::string("sharded")));
+            }
+            BOOST_REQUIRE_EQUAL(dummy_no_default_ctor::m_count, 22);
+        }
+        BOOST_REQUIRE_EQUAL(dummy_no_default_ctor::m_count, 2);
+        BOOST_REQUIRE_EQUAL(item->m_name, "concurrent");
+        BOOST_REQUIRE_EQUAL(sharded_item->m_name, "sharded");
+        pool.check();
+        sharded_pool.check();
+    }
+    BOOST_REQUIRE_EQUAL(dummy_no_default_ctor::m_count, 0);
+
+    // items having a default ctor are constructed by it and then initialized through init() or the given function
+    int32_t initial_count = dummy_compact::m_count;
+    {
+        boost_intrusive_pool<dummy_compact> pool(4, 4, BOOST_INTRUSIVE_POOL_NO_MAX_SIZE, RECYCLE_METHOD_DTOR);
+        BOOST_REQUIRE_EQUAL(dummy_compact::m_count, initial_count);
+
+        boost::intrusive_ptr<dummy_compact> item1 = pool.allocate();
+        boost::intrusive_ptr<dummy_compact> item2 = pool.allocate_through_init(7u);
+        boost::intrusive_ptr<dummy_compact> item3
+            = pool.allocate_through_function([](dummy_compact& item) { item.m_value = 9; });
+        BOOST_REQUIRE_EQUAL(dummy_compact::m_count, initial_count + 3);
+        BOOST_REQUIRE_EQUAL(item1->m_value, 0);
+        BOOST_REQUIRE_EQUAL(item2->m_value, 7);
+        BOOST_REQUIRE_EQUAL(item3->m_value, 9);
+
+        item2 = nullptr;
+        BOOST_REQUIRE_EQUAL(dummy_compact::m_count, initial_count + 2);
+        BOOST_REQUIRE_EQUAL(pool.allocate_through_init(5u)->m_value, 5);
+        pool.check();
+    }
+    BOOST_REQUIRE_EQUAL(dummy_compact::m_count, initial_count);
+}
+
+void test_trim()
+{
+    BOOST_TEST_MESSAGE("Starting tests of the release of idle arenas");
+
+    // each enlarge step gets its own arena:
+    const size_t step = boost_intrusive_pool_arena<DummyInt>::items_per_segment() + 1;
+    boost_intrusive_pool<DummyInt> pool(step, step);
+    std::vector<HDummyInt> items;
+    for (unsigned int j = 0; j < 2 * step + 10; j++)
+        items.push_back(pool.allocate_through_init(j));
+    BOOST_REQUIRE_EQUAL(pool.capacity(), 3 * step);
+    BOOST_REQUIRE_EQUAL(pool.enlarge_steps_done(), 3);
+
+    // arenas having items in use are never released
+    BOOST_REQUIRE_EQUAL(pool.shrink_to_fit(), 0);
+
+    // release all items of the second and third arenas: this pool is now made of two idle arenas and a full one
+    items.resize(step);
+    BOOST_REQUIRE_EQUAL(pool.unused_count(), 2 * step);
+    BOOST_REQUIRE_EQUAL(pool.trim(step + 1), 0);
+    BOOST_REQUIRE_EQUAL(pool.trim(step / 2), step);
+    BOOST_REQUIRE_EQUAL(pool.capacity(), 2 * step);
+    BOOST_REQUIRE_EQUAL(pool.enlarge_steps_done(), 2);
+    BOOST_REQUIRE_EQUAL(pool.unused_count(), step);
+    pool.check();
+
+    // at least one free item is kept while items are in use
+    BOOST_REQUIRE_EQUAL(pool.shrink_to_fit(), 0);
+
+    // the pool can grow again, and all remaining items are still usable
+    for (unsigned int j = 0; j < 2 * step; j++)
+        items.push_back(pool.allocate_through_init(step + j));
+    BOOST_REQUIRE_EQUAL(pool.capacity(), 4 * step);
+    for (unsigned int j = 0; j < 3 * step; j++)
+        BOOST_REQUIRE(*items[j] == DummyInt(j));
+    pool.check();
+
+    // once all items are released, the pool is empty
+    items.clear();
+    BOOST_REQUIRE_EQUAL(pool.shrink_to_fit(), 4 * step);
+    BOOST_REQUIRE_EQUAL(pool.capacity(), 0);
+    BOOST_REQUIRE_EQUAL(pool.enlarge_steps_done(), 0);
+    pool.check();
+    items.push_back(pool.allocate());
+    BOOST_REQUIRE_EQUAL(pool.capacity(), step);
+    pool.check();
+
+    // released items of compact pools are removed from the free list, which is threaded through indexes
+    {
+        typedef boost::intrusive_ptr<dummy_compact> HDummyCompact;
+        const size_t compact_step = boost_intrusive_pool_arena<dummy_compact>::items_per_segment() + 1;
+        boost_intrusive_pool<dummy_compact> compact_pool(compact_step, compact_step);
+        std::vector<HDummyCompact> compact_items;
+        for (unsigned int j = 0; j < 2 * compact_step; j++)
+            compact_items.push_back(compact_pool.allocate_through_init(j));
+        BOOST_REQUIRE_EQUAL(compact_pool.capacity(), 3 * compact_step);
+        for (unsigned int j = 0; j < 2 * compact_step; j++)
+            if (j % 2 == 0 || j >= compact_step)
+                compact_items[j] = nullptr; // the first arena is not idle
+        BOOST_REQUIRE_EQUAL(compact_pool.trim(compact_step / 2), 2 * compact_step);
+        compact_pool.check();
+
+        size_t unused = compact_pool.unused_count() - 1; // leave one free item, to avoid enlarging the pool
+        BOOST_REQUIRE_EQUAL(compact_pool.allocate_bulk(unused, std::back_inserter(compact_items)), unused);
+        BOOST_REQUIRE_EQUAL(compact_pool.capacity(), compact_step);
+        for (unsigned int j = 1; j < compact_step; j += 2)
+            BOOST_REQUIRE_EQUAL(compact_items[j]->m_value, j);
+    }
+}
+
+void test_trim_compact_indexes()
+{
+    BOOST_TEST_MESSAGE("Starting tests of the reuse of the indexes of compact items released by trim()");
+
+    // each cycle creates an arena taking 1/64 of the 32-bit index space: without reusing the indexes released by
+    // trim(), the pool could not be enlarged anymore after 64 cycles. Their memory is never touched, apart from the
+    // few items allocated, unless M_PERTURB makes malloc() scramble all of it.
+    mallopt(M_PERTURB, 0);
+    const size_t step = boost_intrusive_pool_compact_item::k_max_items / 64;
+    boost_intrusive_pool<dummy_compact> pool(step, step);
+    for (unsigned int cycle = 0; cycle < 200; cycle++) {
+        boost::intrusive_ptr<dummy_compact> item = pool.allocate_through_init(cycle);
+        BOOST_REQUIRE(item);
+        BOOST_REQUIRE_EQUAL(item->m_value, cycle);
+        BOOST_REQUIRE_EQUAL(pool.capacity(), step);
+        item = nullptr;
+        BOOST_REQUIRE_EQUAL(pool.shrink_to_fit(), step);
+        BOOST_REQUIRE_EQUAL(pool.capacity(), 0);
+    }
+    mallopt(M_PERTURB, 1);
+
+    // indexes released by an arena which is not the last one are given to the next arena
+    const size_t small_step = boost_intrusive_pool_arena<dummy_compact>::items_per_segment() + 1;
+    boost_intrusive_pool<dummy_compact> small_pool(small_step, small_step);
+    std::vector<boost::intrusive_ptr<dummy_compact>> items;
+    for (unsigned int j = 0; j < 3 * small_step - 1; j++)
+        items.push_back(small_pool.allocate_through_init(j));
+    for (unsigned int cycle = 0; cycle < 10; cycle++) {
+        for (unsigned int j = small_step; j < 2 * small_step; j++)
+            items[j] = nullptr; // the second arena is now idle
+        BOOST_REQUIRE_EQUAL(small_pool.trim(0), small_step);
+        small_pool.check();
+        for (unsigned int j = small_step; j < 2 * small_step; j++)
+            items[j] = small_pool.allocate_through_init(j);
+        BOOST_REQUIRE_EQUAL(small_pool.capacity(), 3 * small_step);
+        small_pool.check();
+    }
+    for (unsigned int j = 0; j < 3 * small_step - 1; j++)
+        BOOST_REQUIRE_EQUAL(items[j]->m_value, j);
+}
+
+void test_arena_packing()
+{
+    BOOST_TEST_MESSAGE("Starting tests of the allocation out of the fullest arena");
+
+    // each enlarge step gets its own arena:
+    const size_t step = boost_intrusive_pool_arena<DummyInt>::items_per_segment() + 1;
+    boost_intrusive_pool<DummyInt> pool(step, step);
+    std::vector<HDummyInt> items;
+    for (unsigned int j = 0; j < 3 * step - 1; j++)
+        items.push_back(pool.allocate());
+    BOOST_REQUIRE_EQUAL(pool.capacity(), 3 * step);
+    BOOST_REQUIRE_CLOSE(pool.fragmentation(), 1.0 / (3 * step), 0.001);
+
+    // release a few items of the first arena and most items of the second one
+    std::set<DummyInt*> released_from_first;
+    for (unsigned int j = 0; j < step; j += 10) {
+        released_from_first.insert(items[j].get());
+        items[j] = nullptr;
+    }
+    for (unsigned int j = step; j < 2 * step; j++)
+        if (j % 10 != 0)
+            items[j] = nullptr;
+    double fragmentation = pool.fragmentation();
+    BOOST_REQUIRE(fragmentation > 0.3);
+    pool.check();
+
+    // once the last arena is full, items are allocated out of the fullest arena, i.e. the first one
+    items.push_back(pool.allocate());
+    for (size_t j = 0; j < released_from_first.size() - 1; j++) {
+        items.push_back(pool.allocate());
+        BOOST_REQUIRE_EQUAL(released_from_first.count(items.back().get()), 1);
+    }
+    BOOST_REQUIRE(pool.fragmentation() < fragmentation);
+    pool.check();
+
+    // the second arena becomes idle and can be released
+    for (unsigned int j = step; j < 2 * step; j++)
+        items[j] = nullptr;
+    BOOST_REQUIRE_EQUAL(pool.shrink_to_fit(), step);
+    BOOST_REQUIRE_CLOSE(pool.fragmentation(), 1.0 / (2 * step), 0.001);
+    pool.check();
+
+    items.clear();
+    BOOST_REQUIRE_EQUAL(pool.fragmentation(), 0.0);
+}
+
+void test_growth_policies()
+{
+    BOOST_TEST_MESSAGE("Starting tests of the growth policies");
+
+    // returns the capacities reached by the pool while allocating "count" items one by one; note that the pool is
+    // enlarged as soon as its last free item gets allocated
+    auto observe_growth = [](boost_intrusive_pool<DummyInt>& pool, size_t count) {
+        std::vector<HDummyInt> items;
+        std::vector<size_t> capacities(1, pool.capacity());
+        for (unsigned int j = 0; j < count; j++) {
+            items.push_back(pool.allocate_through_init(j));
+            if (pool.capacity() != capacities.back())
+                capacities.push_back(pool.capacity());
+        }
+        pool.check();
+        return capacities;
+    };
+
+    {
+        // fixed growth is the default
+        boost_intrusive_pool<DummyInt> pool(10, 10);
+        std::vector<size_t> expected = { 10, 20, 30, 40 };
+        BOOST_REQUIRE(observe_growth(pool, 39) == expected);
+    }
+
+    {
+        // geometric growth doubles the enlarge step up to its maximum
+        boost_intrusive_pool<DummyInt> pool(10, 10);
+        pool.set_growth_policy(boost_intrusive_pool_geometric_growth(40));
+        std::vector<size_t> expected = { 10, 20, 40, 80, 120, 160 };
+        BOOST_REQUIRE(observe_growth(pool, 159) == expected);
+        BOOST_REQUIRE_EQUAL(pool.enlarge_steps_done(), 6);
+
+        // the policy survives clear()
+        pool.clear();
+        expected = { 0, 10, 20, 40 };
+        BOOST_REQUIRE(observe_growth(pool, 39) == expected);
+    }
+
+    {
+        // adaptive growth: with a long horizon the pool seems to run out of items very fast...
+        boost_intrusive_pool<DummyInt> pool(10, 10);
+        pool.set_growth_policy(boost_intrusive_pool_adaptive_growth(std::chrono::hours(1), 1000));
+        std::vector<size_t> expected = { 10, 1010 };
+        BOOST_REQUIRE(observe_growth(pool, 20) == expected);
+    }
+
+    {
+        // ...while with a zero horizon it never needs more than enlarge_size items
+        boost_intrusive_pool<DummyInt> pool(10, 10);
+        pool.set_growth_policy(boost_intrusive_pool_adaptive_growth(std::chrono::seconds(0), 1000));
+        std::vector<size_t> expected = { 10, 20, 30 };
+        BOOST_REQUIRE(observe_growth(pool, 29) == expected);
+    }
+
+    {
+        // custom policies see the state of the pool; the steps are still limited by max_size
+        boost_intrusive_pool<DummyInt> pool(10, 5, 100);
+        size_t num_calls = 0;
+        pool.set_growth_policy([&num_calls](const boost_intrusive_pool_growth_info& info) {
+            BOOST_REQUIRE_EQUAL(info.m_enlarge_size, 5);
+            BOOST_REQUIRE_EQUAL(info.m_enlarge_steps, num_calls + 1);
+            BOOST_REQUIRE_EQUAL(info.m_last_enlarge_size, num_calls == 0 ? 10 : info.m_capacity / 2);
+            num_calls++;
+            return info.m_capacity;
+        });
+        std::vector<size_t> expected = { 10, 20, 40, 80, 100 };
+        BOOST_REQUIRE(observe_growth(pool, 99) == expected);
+        BOOST_REQUIRE_EQUAL(num_calls, 4);
+    }
+
+    {
+        // with geometric growth the number of enlarge steps is logarithmic also for concurrent memory pools
+        concurrent_boost_intrusive_pool<DummyInt> pool(1, 1);
+        pool.set_growth_policy(boost_intrusive_pool_geometric_growth());
+        std::vector<HDummyInt> items;
+        for (unsigned int j = 0; j < 1000; j++)
+            items.push_back(pool.allocate());
+        BOOST_REQUIRE_EQUAL(pool.capacity(), 1024);
+        BOOST_REQUIRE_EQUAL(pool.enlarge_steps_done(), 11);
+    }
+}
+
+void test_recycle_policies()
+{
+    BOOST_TEST_MESSAGE("Starting tests of memory pools using recycle policies chosen at compile time");
+
+    // destroy() is invoked only by the recycle policies asking for it
+    {
+        boost_intrusive_pool<dummy_level3, boost_intrusive_pool_no_recycle> pool(2);
+        boost_intrusive_pool<dummy_level3, boost_intrusive_pool_destroy_recycle> destroy_pool(2);
+        boost_intrusive_pool<dummy_level3, boost_intrusive_pool_auto_recycle> auto_pool(2);
+        dummy_level3* raw_item = pool.allocate_through_init().get();
+        BOOST_REQUIRE(!raw_item->m_destroyed);
+        raw_item = destroy_pool.allocate_through_init().get();
+        BOOST_REQUIRE(raw_item->m_destroyed);
+        raw_item = auto_pool.allocate_through_init().get();
+        BOOST_REQUIRE(raw_item->m_destroyed);
+
+        boost_intrusive_pool<dummy_overloaded_destroy, boost_intrusive_pool_auto_recycle> overloaded_pool(2);
+        dummy_overloaded_destroy* overloaded_item = overloaded_pool.allocate_through_init().get();
+        BOOST_REQUIRE(overloaded_item->m_destroyed);
+    }
+    {
+        boost_intrusive_pool<dummy_compact, boost_intrusive_pool_auto_recycle> pool(2);
+        boost_intrusive_pool<dummy_shared, boost_intrusive_pool_auto_recycle> other_pool(2); // no destroy() here
+        dummy_compact* raw_item = pool.allocate_through_init(5u).get();
+        BOOST_REQUIRE_EQUAL(raw_item->m_value, 0);
+        BOOST_REQUIRE_EQUAL(other_pool.allocate_through_init(5u)->m_value, 5);
+        pool.check();
+        other_pool.check();
+    }
+
+    // any callable can be a recycle policy, also with bulk operations and after clear()
+    counting_recycle::m_count = 0;
+    {
+        boost_intrusive_pool<DummyInt, counting_recycle> pool(10);
+        std::vector<HDummyInt> items;
+        BOOST_REQUIRE_EQUAL(pool.allocate_bulk_through_init(20, std::back_inserter(items), 5), 20);
+        pool.release_bulk(items);
+        BOOST_REQUIRE_EQUAL(counting_recycle::m_count, 20);
+
+        pool.clear();
+        pool.allocate();
+        BOOST_REQUIRE_EQUAL(counting_recycle::m_count, 21);
+        pool.check();
+    }
+    {
+        concurrent_boost_intrusive_pool<DummyInt, counting_recycle> pool(10);
+        sharded_boost_intrusive_pool<DummyInt, counting_recycle> sharded_pool(10);
+        pool.allocate();
+        sharded_pool.allocate();
+        BOOST_REQUIRE_EQUAL(counting_recycle::m_count, 23);
+        pool.check();
+        sharded_pool.check();
+    }
+}
+
+void test_release_bulk()
+{
+    BOOST_TEST_MESSAGE("Starting tests of the bulk release method");
+
+    unsigned int num_recycled = 0;
+    boost_intrusive_pool<DummyInt> pool(
+        10, 10, BOOST_INTRUSIVE_POOL_NO_MAX_SIZE, RECYCLE_METHOD_CUSTOM_FUNCTION, [&num_recycled](DummyInt& item) {
+            item.destroy();
+            num_recycled++;
+        });
+    boost_intrusive_pool<DummyInt> other_pool(10, 10);
+
+    std::vector<HDummyInt> batch;
+    BOOST_REQUIRE_EQUAL(pool.allocate_bulk_through_init(20, std::back_inserter(batch), 5), 20);
+    batch.push_back(other_pool.allocate_through_init(6)); // an item of another pool
+    batch.push_back(HDummyInt(new DummyInt(7))); // an item not belonging to any pool
+    batch.push_back(nullptr);
+    HDummyInt still_referenced = batch[3];
+
+    pool.release_bulk(batch);
+
+    BOOST_REQUIRE_EQUAL(batch.size(), 23);
+    for (auto& item : batch)
+        BOOST_REQUIRE(!item);
+    BOOST_REQUIRE_EQUAL(num_recycled, 19);
+    BOOST_REQUIRE_EQUAL(pool.inuse_count(), 1);
+    BOOST_REQUIRE_EQUAL(other_pool.inuse_count(), 0);
+    BOOST_REQUIRE(*still_referenced == DummyInt(5));
+    pool.check();
+
+    still_referenced = nullptr;
+    BOOST_REQUIRE_EQUAL(num_recycled, 20);
+    BOOST_REQUIRE(pool.empty());
+
+    // a bulk release from a thread not owning the pool goes through the remote free list:
+    batch.clear();
+    BOOST_REQUIRE_EQUAL(pool.allocate_bulk(15, std::back_inserter(batch)), 15);
+    std::thread th([&pool, &batch]() { pool.release_bulk(batch); });
+    th.join();
+    BOOST_REQUIRE_EQUAL(pool.inuse_count(), 15);
+    BOOST_REQUIRE_EQUAL(num_recycled, 20);
+
+    size_t capacity = pool.capacity();
+    batch.clear();
+    BOOST_REQUIRE_EQUAL(pool.allocate_bulk(capacity, std::back_inserter(batch)), capacity); // drains the inbox
+    BOOST_REQUIRE_EQUAL(num_recycled, 20 + 15);
+    BOOST_REQUIRE_EQUAL(pool.inuse_count(), capacity);
+    pool.check();
+}
+
+void test_deep_class_hierarchy()
+{
+    boost_intrusive_pool<dummy_level3> pool(2, 2, BOOST_INTRUSIVE_POOL_NO_MAX_SIZE, RECYCLE_METHOD_DESTROY_FUNCTION);
+
+    std::vector<boost::intrusive_ptr<dummy_level3>> items;
+    for (unsigned int j = 0; j < 10; j++) {
+        items.push_back(pool.allocate_through_init());
+        BOOST_REQUIRE_EQUAL(items.back()->level(), 3);
+        BOOST_REQUIRE(!items.back()->m_destroyed);
+    }
+
+    dummy_level3* raw_item = items.front().get();
+    items.clear();
+    BOOST_REQUIRE(raw_item->m_destroyed); // the recycle method has been invoked on the right object
+
+    pool.check();
+    BOOST_REQUIRE(pool.empty());
+}
+
 /// Test that everything works even if the pool dies before the
 /// objects allocated
 void pool_die_before_object()
@@ -438,10 +1457,30 @@ void pool_die_before_object()
             d2 = pool.allocate();
             d3 = pool.allocate();
 
-            BOOST_REQUIRE_EQUAL(dummy_one::m_count, BOOST_INTRUSIVE_POOL_DEFAULT_POOL_SIZE);
+            BOOST_REQUIRE_EQUAL(dummy_one::m_count, 3);
         }
 
-        BOOST_REQUIRE_EQUAL(dummy_one::m_count, BOOST_INTRUSIVE_POOL_DEFAULT_POOL_SIZE);
+        BOOST_REQUIRE_EQUAL(dummy_one::m_count, 3);
+    }
+
+    BOOST_REQUIRE_EQUAL(dummy_one::m_count, 0);
+
+    // now with items spread over many arenas, all finding their owner from their address:
+    {
+        std::vector<boost::intrusive_ptr<dummy_one>> items;
+        {
+            boost_intrusive_pool<dummy_one> pool(16, 16);
+            for (unsigned int j = 0; j < 10000; j++) {
+                items.push_back(pool.allocate());
+                BOOST_REQUIRE(items.back()->_refcounted_item_get_pool() == items.front()->_refcounted_item_get_pool());
+            }
+            BOOST_REQUIRE(pool.enlarge_steps_done() > 1);
+        }
+
+        // release the items in a different order than the allocation one:
+        for (unsigned int j = 0; j < items.size(); j += 2)
+            items[j] = nullptr;
+        BOOST_REQUIRE(dummy_one::m_count > 0);
     }
 
     BOOST_REQUIRE_EQUAL(dummy_one::m_count, 0);
@@ -505,6 +1544,600 @@ void overwrite_pool_items_with_other_pool_items()
     BOOST_REQUIRE_EQUAL(pool.unused_count(), 0);
 }
 
+void remote_free_memory_pool()
+{
+    BOOST_TEST_MESSAGE("Starting boost_intrusive_pool<> tests when items are released by another thread");
+
+    const unsigned int pool_size = 100;
+
+    boost_intrusive_pool<DummyInt> pool(pool_size, 0 /* enlarge step */);
+    std::vector<HDummyInt> helper_container;
+
+    for (unsigned int j = 0; j < pool_size; j++)
+        helper_container.push_back(pool.allocate_through_init(j));
+    BOOST_REQUIRE(!pool.allocate());
+
+    // release all items from another thread: they will land in the remote free list
+    std::thread th([&helper_container]() { helper_container.clear(); });
+    th.join();
+
+    // items in the remote free list are counted as in use until the owner thread needs them:
+    BOOST_REQUIRE_EQUAL(pool.inuse_count(), pool_size);
+    BOOST_REQUIRE_EQUAL(pool.unused_count(), 0);
+    pool.check();
+
+    // now the owner thread should be able to reuse all items without enlarging the pool:
+    for (unsigned int j = 0; j < pool_size; j++) {
+        HDummyInt myInt = pool.allocate_through_init(j);
+        BOOST_REQUIRE(myInt);
+        helper_container.push_back(myInt);
+    }
+    BOOST_REQUIRE(!pool.allocate());
+    BOOST_REQUIRE_EQUAL(pool.enlarge_steps_done(), 1); // just the initial one
+
+    helper_container.clear();
+    pool.check();
+    BOOST_REQUIRE(pool.empty());
+}
+
+void remote_free_hand_over()
+{
+    BOOST_TEST_MESSAGE("Starting boost_intrusive_pool<> tests when the pool is handed over to another thread");
+
+    const unsigned int pool_size = 10;
+
+    // the pool is created and warmed up by this thread...
+    boost_intrusive_pool<DummyInt> pool(pool_size, 0 /* enlarge step */);
+    HDummyInt kept_item = pool.allocate_through_init(1);
+    BOOST_REQUIRE(pool.get_owner_thread() == std::this_thread::get_id());
+
+    // ...and then handed over to a worker, which hands it back when done
+    std::atomic<bool> handed_over(false);
+    size_t inuse_after_release = 0, inuse_after_drain = 0;
+    const std::thread::id main_thread = std::this_thread::get_id();
+    std::thread worker([&]() {
+        while (!handed_over.load(std::memory_order_acquire))
+            std::this_thread::yield();
+
+        std::vector<HDummyInt> items;
+        for (unsigned int j = 0; j < pool_size - 2; j++) // without emptying the free list
+            items.push_back(pool.allocate_through_init(j));
+        items.clear(); // the worker owns the pool: these are recycled without going through the remote free list
+        inuse_after_release = pool.inuse_count();
+
+        for (unsigned int j = 0; j < pool_size; j++)
+            items.push_back(pool.allocate_through_init(j)); // drains the item released by the old owner
+        inuse_after_drain = pool.inuse_count();
+        items.clear();
+
+        pool.set_owner_thread(main_thread);
+    });
+    pool.set_owner_thread(worker.get_id());
+    kept_item = nullptr; // the old owner releases items like any other thread
+    handed_over.store(true, std::memory_order_release);
+    worker.join();
+
+    BOOST_REQUIRE_EQUAL(inuse_after_release, 1); // just the item kept by the old owner
+    BOOST_REQUIRE_EQUAL(inuse_after_drain, pool_size);
+    BOOST_REQUIRE(pool.get_owner_thread() == main_thread);
+    BOOST_REQUIRE(pool.empty());
+    pool.check();
+}
+
+void remote_free_producer_consumer()
+{
+    BOOST_TEST_MESSAGE("Starting boost_intrusive_pool<> tests with a producer thread and a consumer thread");
+
+    const unsigned int pool_size = 16;
+    const unsigned int num_items = 100000;
+
+    // the producer can make progress only by reusing the items released by the consumer:
+    boost_intrusive_pool<DummyInt> pool(pool_size, 0 /* enlarge step */);
+    std::mutex queue_lock;
+    std::vector<HDummyInt> queue;
+
+    std::thread consumer([&]() {
+        unsigned int num_consumed = 0;
+        while (num_consumed < num_items) {
+            std::vector<HDummyInt> consumed;
+            {
+                std::lock_guard<std::mutex> guard(queue_lock);
+                consumed.swap(queue);
+            }
+            num_consumed += consumed.size();
+            consumed.clear(); // items get released here
+            std::this_thread::yield();
+        }
+    });
+
+    for (unsigned int j = 0; j < num_items; j++) {
+        HDummyInt myInt;
+        while (!(myInt = pool.allocate_through_init(j)))
+            std::this_thread::yield();
+
+        std::lock_guard<std::mutex> guard(queue_lock);
+        queue.push_back(std::move(myInt)); // DummyInt has a non-atomic refcount: hand the item over
+    }
+    consumer.join();
+
+    BOOST_REQUIRE_EQUAL(pool.capacity(), pool_size);
+    BOOST_REQUIRE_EQUAL(pool.enlarge_steps_done(), 1); // just the initial one
+    pool.check();
+}
+
+void remote_free_pool_die_before_object()
+{
+    dummy_one::m_count = 0;
+
+    std::vector<boost::intrusive_ptr<dummy_one>> items;
+    {
+        boost_intrusive_pool<dummy_one> pool;
+        BOOST_REQUIRE(pool.init());
+
+        for (unsigned int j = 0; j < 100; j++)
+            items.push_back(pool.allocate());
+
+        // release half of the items remotely while the pool is still alive:
+        std::thread th([&items]() { items.resize(50); });
+        th.join();
+    }
+
+    // the pool is still alive since some of its items are still in use:
+    BOOST_REQUIRE(dummy_one::m_count >= 50);
+
+    // the last items returning to the orphan pool from another thread must free it:
+    std::thread th([&items]() { items.clear(); });
+    th.join();
+
+    BOOST_REQUIRE_EQUAL(dummy_one::m_count, 0);
+}
+
+void compact_memory_pool()
+{
+    BOOST_TEST_MESSAGE("Starting boost_intrusive_pool<> tests with compact items");
+
+    typedef boost::intrusive_ptr<dummy_compact> HDummyCompact;
+    const unsigned int num_items = 3 * boost_intrusive_pool_arena<dummy_compact>::items_per_segment();
+
+    boost_intrusive_pool<dummy_compact> pool(
+        10, 100, BOOST_INTRUSIVE_POOL_NO_MAX_SIZE, RECYCLE_METHOD_DESTROY_FUNCTION);
+
+    // items spanning several segments:
+    std::vector<HDummyCompact> items;
+    for (unsigned int j = 0; j < num_items; j++) {
+        items.push_back(pool.allocate_through_init(j));
+        BOOST_REQUIRE(items.back()->is_in_memory_pool());
+        BOOST_REQUIRE_EQUAL(items.back()->use_count(), 1);
+    }
+    pool.check();
+    BOOST_REQUIRE_EQUAL(pool.inuse_count(), num_items);
+    BOOST_REQUIRE_EQUAL(pool.unused_count() + pool.inuse_count(), pool.capacity());
+
+    // release the items in pseudo-random order: the free list is threaded through items of different segments
+    std::set<uint32_t> released;
+    for (unsigned int j = 0; j < num_items; j += 3) {
+        unsigned int idx = (j * 7919) % num_items;
+        if (items[idx]) {
+            items[idx] = nullptr;
+            released.insert(idx);
+        }
+    }
+    pool.check();
+    BOOST_REQUIRE_EQUAL(pool.inuse_count(), num_items - released.size());
+    for (unsigned int j = 0; j < num_items; j++)
+        if (items[j])
+            BOOST_REQUIRE_EQUAL(items[j]->m_value, j); // not touched by recycling other items
+
+    // all released items can be allocated again, without enlarging the pool:
+    size_t capacity = pool.capacity();
+    std::vector<HDummyCompact> batch;
+    BOOST_REQUIRE_EQUAL(pool.allocate_bulk(released.size(), std::back_inserter(batch)), released.size());
+    BOOST_REQUIRE_EQUAL(pool.capacity(), capacity);
+    std::set<dummy_compact*> distinct;
+    for (auto& item : batch) {
+        BOOST_REQUIRE_EQUAL(item->m_value, 0); // destroy() has been invoked on them
+        distinct.insert(item.get());
+    }
+    BOOST_REQUIRE_EQUAL(distinct.size(), batch.size());
+
+    pool.release_bulk(batch);
+    items.clear();
+    BOOST_REQUIRE(pool.empty());
+    pool.check();
+
+    // compact items allocated out of any memory pool:
+    HDummyCompact heap_item(new dummy_compact());
+    BOOST_REQUIRE(!heap_item->is_in_memory_pool());
+    heap_item->check();
+}
+
+void compact_pool_die_before_object()
+{
+    dummy_compact::m_count = 0;
+
+    std::vector<boost::intrusive_ptr<dummy_compact>> items;
+    {
+        boost_intrusive_pool<dummy_compact> pool;
+        BOOST_REQUIRE(pool.init());
+
+        for (unsigned int j = 0; j < 100; j++)
+            items.push_back(pool.allocate());
+
+        // release some items remotely while the pool is still alive:
+        std::thread th([&items]() { items.resize(70); });
+        th.join();
+
+        BOOST_REQUIRE_EQUAL(pool.inuse_count(), 100); // the owner thread did not drain the remote free list yet
+    }
+
+    // the pool is still alive since some of its items are still in use:
+    BOOST_REQUIRE(dummy_compact::m_count >= 70);
+
+    // items can return to the orphan pool from its former owner thread and from other threads;
+    // the last one must free it:
+    items.resize(30);
+    std::thread th([&items]() { items.clear(); });
+    th.join();
+
+    BOOST_REQUIRE_EQUAL(dummy_compact::m_count, 0);
+}
+
+void concurrent_memory_pool()
+{
+    BOOST_TEST_MESSAGE("Starting concurrent_boost_intrusive_pool<> tests with items released by other threads");
+
+    const unsigned int num_threads = 4;
+    const unsigned int num_elements = 20000;
+
+    concurrent_boost_intrusive_pool<DummyInt> pool(16, 16);
+    BOOST_REQUIRE(!pool.is_bounded());
+
+    // each thread allocates items and hands them over to the next thread, which releases them:
+    std::mutex handoff_mutex[num_threads];
+    std::vector<HDummyInt> handoff[num_threads];
+
+    std::vector<std::thread> threads;
+    for (unsigned int t = 0; t < num_threads; t++) {
+        threads.emplace_back([&, t]() {
+            unsigned int next_thread = (t + 1) % num_threads;
+            for (unsigned int j = 0; j < num_elements; j++) {
+                HDummyInt myInt = pool.allocate_through_init(j);
+                assert(myInt);
+
+                if ((j % 3) == 0) {
+                    // NOTE: DummyInt has a non-atomic refcount: the item is handed over, not shared
+                    std::lock_guard<std::mutex> lock(handoff_mutex[next_thread]);
+                    handoff[next_thread].push_back(std::move(myInt));
+                } // else: released immediately by this thread
+
+                if ((j % 64) == 0) {
+                    std::vector<HDummyInt> to_release;
+                    {
+                        std::lock_guard<std::mutex> lock(handoff_mutex[t]);
+                        to_release.swap(handoff[t]);
+                    }
+                    // items allocated by another thread are released here
+                }
+            }
+        });
+    }
+    for (auto& th : threads)
+        th.join();
+
+    for (unsigned int t = 0; t < num_threads; t++)
+        handoff[t].clear();
+
+    pool.check();
+
+    BOOST_REQUIRE_EQUAL(pool.inuse_count(), 0);
+    BOOST_REQUIRE(pool.empty());
+    BOOST_REQUIRE_EQUAL(pool.unused_count(), pool.capacity());
+    BOOST_REQUIRE(pool.enlarge_steps_done() >= 1);
+    BOOST_REQUIRE(!pool.is_memory_exhausted());
+
+    // a function running the ctor of the item again does not unlink the item from the pool
+    {
+        HDummyInt item = pool.allocate_through_function([](DummyInt& x) { new (&x) DummyInt(7); });
+        BOOST_REQUIRE(*item == DummyInt(7));
+    }
+    BOOST_REQUIRE_EQUAL(pool.inuse_count(), 0);
+    pool.check();
+}
+
+void concurrent_bounded_memory_pool()
+{
+    BOOST_TEST_MESSAGE("Starting concurrent_boost_intrusive_pool<> tests when memory pool is bounded");
+
+    const unsigned int num_threads = 4;
+    const unsigned int pool_size = 1000;
+
+    concurrent_boost_intrusive_pool<DummyInt> pool(pool_size, 0 /* enlarge step */);
+    BOOST_REQUIRE(pool.is_bounded());
+
+    // all threads compete to get all items of the pool:
+    std::vector<HDummyInt> allocated[num_threads];
+    std::vector<std::thread> threads;
+    for (unsigned int t = 0; t < num_threads; t++) {
+        threads.emplace_back([&, t]() {
+            while (true) {
+                HDummyInt myInt = pool.allocate_through_init(t);
+                if (!myInt)
+                    break;
+                allocated[t].push_back(myInt);
+            }
+        });
+    }
+    for (auto& th : threads)
+        th.join();
+
+    size_t total_allocated = 0;
+    for (unsigned int t = 0; t < num_threads; t++)
+        total_allocated += allocated[t].size();
+
+    BOOST_REQUIRE_EQUAL(total_allocated, pool_size);
+    BOOST_REQUIRE_EQUAL(pool.inuse_count(), pool_size);
+    BOOST_REQUIRE_EQUAL(pool.unused_count(), 0);
+    BOOST_REQUIRE_EQUAL(pool.enlarge_steps_done(), 1); // just the initial one
+    BOOST_REQUIRE(pool.is_memory_exhausted());
+
+    for (unsigned int t = 0; t < num_threads; t++)
+        allocated[t].clear();
+
+    pool.check();
+    BOOST_REQUIRE(pool.empty());
+    BOOST_REQUIRE_EQUAL(pool.unused_count(), pool_size);
+}
+
+void concurrent_memory_pool_with_magazines()
+{
+    BOOST_TEST_MESSAGE("Starting concurrent_boost_intrusive_pool<> tests with per-thread magazines");
+
+    const unsigned int num_threads = 4;
+    const unsigned int num_elements = 20000;
+    const size_t magazine_size = 8;
+
+    concurrent_boost_intrusive_pool<DummyInt> pool(64, 16);
+    pool.set_magazine_size(magazine_size);
+
+    {
+        // the first allocation refills the magazine of this thread with half of its capacity:
+        HDummyInt myInt = pool.allocate_through_init(1);
+        BOOST_REQUIRE_EQUAL(pool.inuse_count(), magazine_size / 2);
+    }
+
+    // the released item stays in the magazine of this thread:
+    BOOST_REQUIRE_EQUAL(pool.inuse_count(), magazine_size / 2);
+    pool.flush_thread_cache();
+    BOOST_REQUIRE_EQUAL(pool.inuse_count(), 0);
+
+    std::mutex handoff_mutex;
+    std::vector<HDummyInt> handoff;
+
+    std::vector<std::thread> threads;
+    for (unsigned int t = 0; t < num_threads; t++) {
+        threads.emplace_back([&, t]() {
+            std::vector<HDummyInt> window;
+            for (unsigned int j = 0; j < num_elements; j++) {
+                HDummyInt myInt = pool.allocate_through_init(j);
+                assert(myInt);
+                window.push_back(std::move(myInt)); // DummyInt has a non-atomic refcount: hand the item over
+
+                // release items in bursts larger than the magazine capacity, to exercise the spilling logic;
+                // some items are released by other threads
+                if (window.size() == 3 * magazine_size) {
+                    std::lock_guard<std::mutex> lock(handoff_mutex);
+                    handoff.swap(window);
+                    window.clear();
+                }
+            }
+
+            if (t % 2)
+                pool.flush_thread_cache(); // otherwise the magazine gets flushed at thread exit
+        });
+    }
+    for (auto& th : threads)
+        th.join();
+
+    handoff.clear();
+    pool.flush_thread_cache();
+
+    pool.check();
+
+    BOOST_REQUIRE_EQUAL(pool.inuse_count(), 0);
+    BOOST_REQUIRE(pool.empty());
+    BOOST_REQUIRE_EQUAL(pool.unused_count(), pool.capacity());
+}
+
+/// Test that everything works even if the concurrent pool dies before the
+/// objects allocated, which are then released by other threads
+void concurrent_pool_die_before_object()
+{
+    for (size_t magazine_size : { 0, 8 }) {
+        dummy_one::m_count = 0;
+
+        std::vector<boost::intrusive_ptr<dummy_one>> items;
+        {
+            concurrent_boost_intrusive_pool<dummy_one> pool;
+            BOOST_REQUIRE(pool.init());
+            pool.set_magazine_size(magazine_size);
+
+            for (unsigned int j = 0; j < 100; j++)
+                items.push_back(pool.allocate());
+
+            BOOST_REQUIRE(dummy_one::m_count >= 100);
+
+            // the dtor returns the items in the magazine of this thread, which would keep the pool alive otherwise
+            items.pop_back();
+        }
+
+        // the pool is still alive since some of its items are still in use:
+        BOOST_REQUIRE(dummy_one::m_count >= 99);
+
+        std::vector<std::thread> threads;
+        for (unsigned int t = 0; t < 4; t++) {
+            threads.emplace_back([&items, t]() {
+                for (unsigned int j = t; j < items.size(); j += 4)
+                    items[j] = nullptr;
+            });
+        }
+        for (auto& th : threads)
+            th.join();
+
+        BOOST_REQUIRE_EQUAL(dummy_one::m_count, 0);
+    }
+}
+
+void sharded_bounded_memory_pool()
+{
+    BOOST_TEST_MESSAGE("Starting sharded_boost_intrusive_pool<> tests when memory pool is bounded");
+
+    const unsigned int num_shards = 4;
+    const unsigned int pool_size = 102;
+
+    sharded_boost_intrusive_pool<DummyInt> pool(
+        pool_size, 0 /* enlarge step */, BOOST_INTRUSIVE_POOL_NO_MAX_SIZE, RECYCLE_METHOD_NONE, nullptr, num_shards);
+    BOOST_REQUIRE(pool.is_bounded());
+    BOOST_REQUIRE_EQUAL(pool.num_shards(), num_shards);
+
+    // initial items are spread evenly over all shards:
+    for (unsigned int i = 0; i < num_shards; i++)
+        BOOST_REQUIRE_EQUAL(pool.shard_unused_count(i), (i < 2) ? 26 : 25);
+
+    // a single thread must be able to get all items, stealing them from the other shards:
+    std::vector<HDummyInt> helper_container;
+    for (unsigned int j = 0; j < pool_size; j++) {
+        HDummyInt myInt = pool.allocate_through_init(j);
+        BOOST_REQUIRE(myInt);
+        helper_container.push_back(myInt);
+    }
+    BOOST_REQUIRE(!pool.allocate());
+
+    BOOST_REQUIRE_EQUAL(pool.inuse_count(), pool_size);
+    BOOST_REQUIRE_EQUAL(pool.unused_count(), 0);
+    BOOST_REQUIRE_EQUAL(pool.enlarge_steps_done(), 1); // just the initial one
+    BOOST_REQUIRE(pool.is_memory_exhausted());
+    pool.check();
+
+    helper_container.clear();
+    pool.check();
+    BOOST_REQUIRE(pool.empty());
+    BOOST_REQUIRE_EQUAL(pool.unused_count(), pool_size);
+}
+
+void sharded_memory_pool()
+{
+    BOOST_TEST_MESSAGE("Starting sharded_boost_intrusive_pool<> tests with many threads");
+
+    const unsigned int num_threads = 4;
+    const unsigned int num_iterations = 10000;
+
+    sharded_boost_intrusive_pool<DummyInt> pool(16, 16 /* enlarge step */, BOOST_INTRUSIVE_POOL_NO_MAX_SIZE,
+        RECYCLE_METHOD_DESTROY_FUNCTION, nullptr, num_threads);
+
+    std::vector<std::thread> threads;
+    for (unsigned int t = 0; t < num_threads; t++) {
+        threads.emplace_back([&pool, t]() {
+            std::vector<HDummyInt> window;
+            for (unsigned int j = 0; j < num_iterations; j++) {
+                window.push_back(pool.allocate_through_init(j));
+                assert(window.back() && *window.back() == DummyInt(j));
+                if (window.size() > t * 8)
+                    window.erase(window.begin());
+            }
+        });
+    }
+    for (auto& th : threads)
+        th.join();
+
+    pool.check();
+    BOOST_REQUIRE(pool.empty());
+    BOOST_REQUIRE_EQUAL(pool.unused_count(), pool.capacity());
+
+    // a function running the ctor of the item again does not change the shard the item returns to
+    std::vector<std::thread> ctor_threads;
+    for (unsigned int t = 0; t < num_threads; t++) {
+        ctor_threads.emplace_back([&pool]() {
+            for (unsigned int j = 0; j < num_iterations; j++) {
+                uint32_t shard = 0;
+                HDummyInt item = pool.allocate_through_function([j, &shard](DummyInt& x) {
+                    shard = x._refcounted_item_get_shard();
+                    new (&x) DummyInt(j);
+                });
+                assert(item && *item == DummyInt(j));
+                assert(item->_refcounted_item_get_shard() == shard);
+            }
+        });
+    }
+    for (auto& th : ctor_threads)
+        th.join();
+
+    pool.check();
+    BOOST_REQUIRE(pool.empty());
+    BOOST_REQUIRE_EQUAL(pool.unused_count(), pool.capacity());
+}
+
+void sharded_pool_die_before_object()
+{
+    dummy_one::m_count = 0;
+
+    std::vector<boost::intrusive_ptr<dummy_one>> items;
+    {
+        sharded_boost_intrusive_pool<dummy_one> pool(
+            10, 10, BOOST_INTRUSIVE_POOL_NO_MAX_SIZE, RECYCLE_METHOD_NONE, nullptr, 4 /* shards */);
+
+        for (unsigned int j = 0; j < 100; j++)
+            items.push_back(pool.allocate());
+
+        BOOST_REQUIRE_EQUAL(dummy_one::m_count, 100);
+    }
+
+    // the pool is still alive since some of its items are still in use:
+    BOOST_REQUIRE_EQUAL(dummy_one::m_count, 100);
+
+    std::vector<std::thread> threads;
+    for (unsigned int t = 0; t < 4; t++) {
+        threads.emplace_back([&items, t]() {
+            for (unsigned int j = t; j < items.size(); j += 4)
+                items[j] = nullptr;
+        });
+    }
+    for (auto& th : threads)
+        th.join();
+
+    BOOST_REQUIRE_EQUAL(dummy_one::m_count, 0);
+}
+
+void share_item_among_threads()
+{
+    BOOST_TEST_MESSAGE("Starting tests of items using the thread-safe refcount policy");
+
+    const unsigned int num_threads = 4;
+
+    concurrent_boost_intrusive_pool<dummy_shared> pool(10, 0 /* enlarge step */);
+    boost::intrusive_ptr<dummy_shared> item = pool.allocate_through_init(42);
+    BOOST_REQUIRE(item);
+
+    // each thread gets its own copy and then keeps creating/destroying more copies of it concurrently:
+    std::vector<std::thread> threads;
+    for (unsigned int t = 0; t < num_threads; t++) {
+        threads.emplace_back([](boost::intrusive_ptr<dummy_shared> copy) {
+            for (unsigned int j = 0; j < 100000; j++) {
+                boost::intrusive_ptr<dummy_shared> another_copy(copy);
+                assert(another_copy->m_value == 42);
+            }
+        }, item);
+    }
+
+    // the last reference to the item will be dropped by one of the threads:
+    item = nullptr;
+    for (auto& th : threads)
+        th.join();
+
+    BOOST_REQUIRE_EQUAL(pool.inuse_count(), 0);
+    BOOST_REQUIRE_EQUAL(pool.unused_count(), 10);
+    pool.check();
+}
+
 boost::unit_test::test_suite* init_unit_test_suite(int argc, char* argv[])
 {
     // about M_PERTURB:
@@ -522,8 +2155,39 @@ boost::unit_test::test_suite* init_unit_test_suite(int argc, char* argv[])
     test->add(BOOST_TEST_CASE(&max_size_memory_pool));
     test->add(BOOST_TEST_CASE(&test_api));
     test->add(BOOST_TEST_CASE(&test_allocate_methods));
+    test->add(BOOST_TEST_CASE(&test_allocate_bulk_methods));
+    test->add(BOOST_TEST_CASE(&test_allocate_through_function_without_malloc));
+    test->add(BOOST_TEST_CASE(&test_zero_malloc_allocate_and_recycle));
+    test->add(BOOST_TEST_CASE(&test_zero_malloc_intrusive_ptr));
+    test->add(BOOST_TEST_CASE(&test_lazy_construction));
+    test->add(BOOST_TEST_CASE(&test_huge_pages));
+    test->add(BOOST_TEST_CASE(&test_prefaulted_arenas));
+    test->add(BOOST_TEST_CASE(&test_memory_source));
+    test->add(BOOST_TEST_CASE(&test_numa_placement));
+    test->add(BOOST_TEST_CASE(&test_dtor_recycle_method));
+    test->add(BOOST_TEST_CASE(&test_trim));
+    test->add(BOOST_TEST_CASE(&test_trim_compact_indexes));
+    test->add(BOOST_TEST_CASE(&test_arena_packing));
+    test->add(BOOST_TEST_CASE(&test_growth_policies));
+    test->add(BOOST_TEST_CASE(&test_recycle_policies));
+    test->add(BOOST_TEST_CASE(&test_release_bulk));
+    test->add(BOOST_TEST_CASE(&test_deep_class_hierarchy));
     test->add(BOOST_TEST_CASE(&pool_die_before_object));
     test->add(BOOST_TEST_CASE(&overwrite_pool_items_with_other_pool_items));
+    test->add(BOOST_TEST_CASE(&remote_free_memory_pool));
+    test->add(BOOST_TEST_CASE(&remote_free_hand_over));
+    test->add(BOOST_TEST_CASE(&remote_free_producer_consumer));
+    test->add(BOOST_TEST_CASE(&remote_free_pool_die_before_object));
+    test->add(BOOST_TEST_CASE(&compact_memory_pool));
+    test->add(BOOST_TEST_CASE(&compact_pool_die_before_object));
+    test->add(BOOST_TEST_CASE(&concurrent_memory_pool));
+    test->add(BOOST_TEST_CASE(&concurrent_bounded_memory_pool));
+    test->add(BOOST_TEST_CASE(&concurrent_memory_pool_with_magazines));
+    test->add(BOOST_TEST_CASE(&concurrent_pool_die_before_object));
+    test->add(BOOST_TEST_CASE(&sharded_bounded_memory_pool));
+    test->add(BOOST_TEST_CASE(&sharded_memory_pool));
+    test->add(BOOST_TEST_CASE(&sharded_pool_die_before_object));
+    test->add(BOOST_TEST_CASE(&share_item_among_threads));
 
     return test;
 }